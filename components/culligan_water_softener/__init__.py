@@ -3,18 +3,22 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import ble_client, esp32_ble_tracker
 from esphome.const import CONF_ID
+from esphome.core import CORE
 
 CONF_ESP32_BLE_ID = "esp32_ble_id"
 
-DEPENDENCIES = ["ble_client", "esp32_ble_tracker"]
+# ble_client and esp32_ble_tracker are required through the schema, and only
+# on ESP32: the protocol core has no BLE types (see _validate_platform)
+DEPENDENCIES = []
 CODEOWNERS = ["@your-github-username"]
 MULTI_CONF = True
 
 # Component namespace
 culligan_ns = cg.esphome_ns.namespace("culligan_water_softener")
+CulliganProtocol = culligan_ns.class_("CulliganProtocol", cg.Component)
 CulliganWaterSoftener = culligan_ns.class_(
     "CulliganWaterSoftener",
-    cg.Component,
+    CulliganProtocol,
     ble_client.BLEClientNode,
     esp32_ble_tracker.ESPBTDeviceListener,
 )
@@ -25,6 +29,7 @@ RegenNextButton = culligan_ns.class_("RegenNextButton", cg.Component)
 SyncTimeButton = culligan_ns.class_("SyncTimeButton", cg.Component)
 ResetGallonsButton = culligan_ns.class_("ResetGallonsButton", cg.Component)
 ResetRegensButton = culligan_ns.class_("ResetRegensButton", cg.Component)
+DumpTraceButton = culligan_ns.class_("DumpTraceButton", cg.Component)
 
 # Switch class
 DisplaySwitch = culligan_ns.class_("DisplaySwitch", cg.Component)
@@ -45,6 +50,16 @@ LowSaltAlertNumber = culligan_ns.class_("LowSaltAlertNumber", cg.Component)
 BrineTankTypeNumber = culligan_ns.class_("BrineTankTypeNumber", cg.Component)
 BrineFillHeightNumber = culligan_ns.class_("BrineFillHeightNumber", cg.Component)
 
+
+def use_entity(entity_id):
+    """Mark a registry id (e.g. SensorId.SENSOR_CURRENT_FLOW) as configured.
+
+    Adds -DCULLIGAN_USE_<id>; a range id such as SENSOR_USAGE_STAT covers the
+    whole range. Ids no instance configures are compiled out of the decoders.
+    """
+    cg.add_build_flag("-DCULLIGAN_USE_" + str(entity_id).rsplit("::", 1)[-1])
+
+
 # Custom units
 UNIT_GPM = "GPM"
 UNIT_GPG = "GPG"
@@ -57,24 +72,60 @@ UNIT_GRAINS = "grains"
 # Configuration keys
 CONF_PASSWORD = "password"
 CONF_POLL_INTERVAL = "poll_interval"
+CONF_FAST_POLL_INTERVAL = "fast_poll_interval"
+CONF_STATISTICS_INTERVAL = "statistics_interval"
 CONF_AUTO_DISCOVER = "auto_discover"
 CONF_DEVICE_NAME = "device_name"
+CONF_HEARTBEAT_INTERVAL = "heartbeat_interval"
+CONF_FLOW_DEADBAND = "flow_deadband"
+CONF_SALT_DEADBAND = "salt_deadband"
+CONF_CONNECTION_SLOTS = "connection_slots"
+CONF_DUTY_CYCLE = "duty_cycle"
+CONF_TRACE_BUFFER_SIZE = "trace_buffer_size"
+CONF_QUIET_DECODE = "quiet_decode"
 
 # Default device name for Culligan water softeners
 DEFAULT_DEVICE_NAME = "CS_Meter_Soft"
 
+
+def _validate_platform(config):
+    """BLE is the only transport, so the component itself needs ESP32.
+
+    Checked before the schema so other platforms get this message rather than
+    a missing ble_client. The protocol core builds off-device through
+    host/CMakeLists.txt.
+    """
+    if not CORE.is_esp32:
+        raise cv.Invalid(
+            "culligan_water_softener talks to the softener over ESP32 BLE "
+            "(ble_client and esp32_ble_tracker) and is only available on ESP32"
+        )
+    return config
+
+
 # Configuration schema
-CONFIG_SCHEMA = cv.Schema(
+_BLE_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(CulliganWaterSoftener),
         cv.GenerateID(CONF_ESP32_BLE_ID): cv.use_id(esp32_ble_tracker.ESP32BLETracker),
         cv.Optional(CONF_PASSWORD, default=1234): cv.int_range(min=0, max=9999),
         cv.Optional(CONF_POLL_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_FAST_POLL_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_STATISTICS_INTERVAL, default="5min"): cv.positive_time_period_milliseconds,
         cv.Optional(CONF_AUTO_DISCOVER, default=True): cv.boolean,
         cv.Optional(CONF_DEVICE_NAME, default=DEFAULT_DEVICE_NAME): cv.string,
+        cv.Optional(CONF_HEARTBEAT_INTERVAL, default="15min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_FLOW_DEADBAND, default=0.0): cv.positive_float,
+        cv.Optional(CONF_SALT_DEADBAND, default=0.0): cv.positive_float,
+        cv.Optional(CONF_CONNECTION_SLOTS): cv.int_range(min=1, max=9),
+        cv.Optional(CONF_DUTY_CYCLE, default=False): cv.boolean,
+        cv.Optional(CONF_TRACE_BUFFER_SIZE): cv.int_range(min=64, max=65536),
+        cv.Optional(CONF_QUIET_DECODE, default=False): cv.boolean,
     }
 ).extend(cv.COMPONENT_SCHEMA).extend(ble_client.BLE_CLIENT_SCHEMA)
 
+CONFIG_SCHEMA = cv.All(_validate_platform, _BLE_SCHEMA)
+
 
 async def to_code(config):
     """Generate C++ code for the component."""
@@ -86,6 +137,9 @@ async def to_code(config):
     ble_tracker = await cg.get_variable(config[CONF_ESP32_BLE_ID])
     cg.add(ble_tracker.register_listener(var))
 
+    # Key for the warm-start caches persisted in preferences
+    cg.add(var.set_cache_key(config[CONF_ID].id))
+
     # Set password
     if CONF_PASSWORD in config:
         cg.add(var.set_password(config[CONF_PASSWORD]))
@@ -94,6 +148,35 @@ async def to_code(config):
     if CONF_POLL_INTERVAL in config:
         cg.add(var.set_poll_interval(config[CONF_POLL_INTERVAL]))
 
+    # Status-only poll interval while water flows or a regen is running
+    cg.add(var.set_fast_poll_interval(config[CONF_FAST_POLL_INTERVAL]))
+
+    # Totals and usage history change slowly; settings are read at connect and after writes
+    cg.add(var.set_statistics_interval(config[CONF_STATISTICS_INTERVAL]))
+
+    # Change-only publishing: deadbands and forced republish interval
+    cg.add(var.set_heartbeat_interval(config[CONF_HEARTBEAT_INTERVAL]))
+    cg.add(var.set_flow_deadband(config[CONF_FLOW_DEADBAND]))
+    cg.add(var.set_salt_deadband(config[CONF_SALT_DEADBAND]))
+
     # Set auto-discovery options
     cg.add(var.set_auto_discover(config[CONF_AUTO_DISCOVER]))
     cg.add(var.set_device_name(config[CONF_DEVICE_NAME]))
+
+    # Time-slice connections when more softeners than BLE connections are configured
+    if CONF_CONNECTION_SLOTS in config:
+        cg.add(var.set_connection_slots(config[CONF_CONNECTION_SLOTS]))
+
+    # Connect, poll and disconnect once per poll interval instead of staying connected
+    cg.add(var.set_duty_cycle(config[CONF_DUTY_CYCLE]))
+
+    # Record notifications and writes for dump_trace / replay_trace
+    if CONF_TRACE_BUFFER_SIZE in config:
+        cg.add(var.set_trace_buffer_size(config[CONF_TRACE_BUFFER_SIZE]))
+
+    # Compile out the per-frame decode logs (build flag, shared by all instances)
+    if config[CONF_QUIET_DECODE]:
+        cg.add_build_flag("-DCULLIGAN_QUIET_DECODE")
+
+    # Decode only what some instance publishes; the platforms add use_entity() flags
+    cg.add_build_flag("-DCULLIGAN_ENTITY_SELECTION")
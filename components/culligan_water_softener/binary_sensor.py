@@ -3,7 +3,7 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import binary_sensor
 from esphome.const import CONF_ID
-from . import CulliganWaterSoftener, culligan_ns
+from . import CulliganWaterSoftener, culligan_ns, use_entity
 
 DEPENDENCIES = ["culligan_water_softener"]
 
@@ -20,6 +20,19 @@ CONF_RENTAL_UNIT = "rental_unit"
 CONF_PREFILL_ENABLED = "prefill_enabled"
 CONF_PREFILL_SOAK_MODE = "prefill_soak_mode"
 
+BinarySensorId = culligan_ns.enum("BinarySensorId")
+# Registry id each binary sensor key is registered under
+BINARY_SENSORS = {
+    CONF_DISPLAY_OFF: BinarySensorId.BINARY_SENSOR_DISPLAY_OFF,
+    CONF_BYPASS_ACTIVE: BinarySensorId.BINARY_SENSOR_BYPASS_ACTIVE,
+    CONF_SHUTOFF_ACTIVE: BinarySensorId.BINARY_SENSOR_SHUTOFF_ACTIVE,
+    CONF_REGEN_ACTIVE: BinarySensorId.BINARY_SENSOR_REGEN_ACTIVE,
+    CONF_RENTAL_REGEN_DISABLED: BinarySensorId.BINARY_SENSOR_RENTAL_REGEN_DISABLED,
+    CONF_RENTAL_UNIT: BinarySensorId.BINARY_SENSOR_RENTAL_UNIT,
+    CONF_PREFILL_ENABLED: BinarySensorId.BINARY_SENSOR_PREFILL_ENABLED,
+    CONF_PREFILL_SOAK_MODE: BinarySensorId.BINARY_SENSOR_PREFILL_SOAK_MODE,
+}
+
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_CULLIGAN_WATER_SOFTENER_ID): cv.use_id(CulliganWaterSoftener),
@@ -55,34 +68,8 @@ async def to_code(config):
     """Generate binary sensor code."""
     parent = await cg.get_variable(config[CONF_CULLIGAN_WATER_SOFTENER_ID])
 
-    if CONF_DISPLAY_OFF in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_DISPLAY_OFF])
-        cg.add(parent.set_display_off_sensor(sens))
-
-    if CONF_BYPASS_ACTIVE in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_BYPASS_ACTIVE])
-        cg.add(parent.set_bypass_active_sensor(sens))
-
-    if CONF_SHUTOFF_ACTIVE in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_SHUTOFF_ACTIVE])
-        cg.add(parent.set_shutoff_active_sensor(sens))
-
-    if CONF_REGEN_ACTIVE in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_REGEN_ACTIVE])
-        cg.add(parent.set_regen_active_sensor(sens))
-
-    if CONF_RENTAL_REGEN_DISABLED in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_RENTAL_REGEN_DISABLED])
-        cg.add(parent.set_rental_regen_disabled_sensor(sens))
-
-    if CONF_RENTAL_UNIT in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_RENTAL_UNIT])
-        cg.add(parent.set_rental_unit_sensor(sens))
-
-    if CONF_PREFILL_ENABLED in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_PREFILL_ENABLED])
-        cg.add(parent.set_prefill_enabled_sensor(sens))
-
-    if CONF_PREFILL_SOAK_MODE in config:
-        sens = await binary_sensor.new_binary_sensor(config[CONF_PREFILL_SOAK_MODE])
-        cg.add(parent.set_prefill_soak_mode_sensor(sens))
+    for key, entity_id in BINARY_SENSORS.items():
+        if key in config:
+            sens = await binary_sensor.new_binary_sensor(config[key])
+            cg.add(parent.set_binary_sensor(entity_id, sens))
+            use_entity(entity_id)
@@ -2,7 +2,7 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import button
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, ENTITY_CATEGORY_DIAGNOSTIC
 from . import (
     CulliganWaterSoftener,
     culligan_ns,
@@ -11,6 +11,7 @@ from . import (
     SyncTimeButton,
     ResetGallonsButton,
     ResetRegensButton,
+    DumpTraceButton,
 )
 
 DEPENDENCIES = ["culligan_water_softener"]
@@ -24,6 +25,7 @@ CONF_REGEN_NEXT = "regenerate_next"
 CONF_SYNC_TIME = "sync_time"
 CONF_RESET_GALLONS = "reset_gallons"
 CONF_RESET_REGENS = "reset_regenerations"
+CONF_DUMP_TRACE = "dump_trace"
 
 CONFIG_SCHEMA = cv.Schema(
     {
@@ -48,35 +50,37 @@ CONFIG_SCHEMA = cv.Schema(
             ResetRegensButton,
             icon="mdi:counter",
         ),
+        cv.Optional(CONF_DUMP_TRACE): button.button_schema(
+            DumpTraceButton,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            icon="mdi:file-export",
+        ),
     }
 )
 
 
 async def to_code(config):
     """Generate button code."""
-    parent = await cg.get_variable(config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-
     if CONF_REGEN_NOW in config:
         btn = await button.new_button(config[CONF_REGEN_NOW])
         await cg.register_parented(btn, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_regen_now_button(btn))
 
     if CONF_REGEN_NEXT in config:
         btn = await button.new_button(config[CONF_REGEN_NEXT])
         await cg.register_parented(btn, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_regen_next_button(btn))
 
     if CONF_SYNC_TIME in config:
         btn = await button.new_button(config[CONF_SYNC_TIME])
         await cg.register_parented(btn, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_sync_time_button(btn))
 
     if CONF_RESET_GALLONS in config:
         btn = await button.new_button(config[CONF_RESET_GALLONS])
         await cg.register_parented(btn, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_reset_gallons_button(btn))
 
     if CONF_RESET_REGENS in config:
         btn = await button.new_button(config[CONF_RESET_REGENS])
         await cg.register_parented(btn, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_reset_regens_button(btn))
+
+    if CONF_DUMP_TRACE in config:
+        btn = await button.new_button(config[CONF_DUMP_TRACE])
+        await cg.register_parented(btn, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
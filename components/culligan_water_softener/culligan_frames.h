@@ -0,0 +1,346 @@
+/**
+ * Culligan Water Softener frame layouts
+ *
+ * Compile-time description of every decoded frame: header, packet number,
+ * wire length, end marker and the offset/width/endianness/scale of each
+ * field. Decoders read fields through these descriptors, so offsets live in
+ * one place and a layout that overruns its frame fails to compile.
+ *
+ * Protocol: BIG-ENDIAN for all multi-byte values (see PROTOCOL.md)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace culligan_water_softener {
+
+// End markers for packet validation
+static const uint8_t END_MARKER_UU_0 = 0x39;  // '9'
+static const uint8_t END_MARKER_UU_1 = 0x3A;  // ':'
+static const uint8_t END_MARKER_UU_2 = 0x3B;  // ';'
+static const uint8_t END_MARKER_UU_3 = 0x3C;  // '<'
+static const uint8_t END_MARKER_UU_4 = 0x3D;  // '='
+static const uint8_t END_MARKER_UU_5 = 0x3E;  // '>'
+static const uint8_t END_MARKER_VV_0 = 0x42;  // 'B'
+static const uint8_t END_MARKER_VV_1 = 0x43;  // 'C'
+static const uint8_t END_MARKER_WW_0 = 0x46;  // 'F'
+static const uint8_t END_MARKER_WW_1_END = 0x38;  // '8', after the last usage continuation
+static const uint8_t END_MARKER_WW_2 = 0x48;  // 'H'
+static const uint8_t END_MARKER_WW_3 = 0x49;  // 'I'
+
+// Big-endian helpers over a contiguous frame (inline for performance)
+inline uint16_t read_uint16_be(const uint8_t *data) {
+  return (static_cast<uint16_t>(data[0]) << 8) | static_cast<uint16_t>(data[1]);
+}
+
+inline uint32_t read_uint24_be(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[0]) << 16) | (static_cast<uint32_t>(data[1]) << 8) |
+         static_cast<uint32_t>(data[2]);
+}
+
+inline uint32_t read_uint32_be(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+// Little-endian helpers over a contiguous frame (inline for performance)
+inline uint16_t read_uint16_le(const uint8_t *data) {
+  return static_cast<uint16_t>(data[0]) | (static_cast<uint16_t>(data[1]) << 8);
+}
+
+inline uint32_t read_uint32_le(const uint8_t *data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+namespace frames {
+
+// Longest frame on the wire (one notification)
+static const uint8_t MAX_FRAME_LENGTH = 20;
+
+/**
+ * Wire facts as PROTOCOL.md states them, written independently of the
+ * layouts below so the static_asserts check one against the other.
+ */
+namespace wire {
+static const uint8_t NOTIFICATION_LENGTH = 20;  // "all packets are 20 bytes"
+static const uint8_t HANDSHAKE_LENGTH = 18;     // tt example response
+static const uint8_t PAYLOAD_OFFSET = 3;        // after "xx" and the packet number
+static const uint8_t MARKER_OFFSET = 19;        // "end marker at byte 19"
+static const uint8_t WW0_MARKER_OFFSET = 18;    // ww-0 arrives one byte short
+static const uint8_t WW1_TAIL_LENGTH = 6;       // last ww-1 continuation, 5 days + marker
+}  // namespace wire
+
+enum class Endian : uint8_t { BIG, LITTLE };
+
+// Width/endianness dispatch, resolved at compile time
+template<uint8_t Width, Endian E> struct FieldReader;
+template<Endian E> struct FieldReader<1, E> {
+  static inline uint32_t read(const uint8_t *p) { return p[0]; }
+};
+template<> struct FieldReader<2, Endian::BIG> {
+  static inline uint32_t read(const uint8_t *p) { return read_uint16_be(p); }
+};
+template<> struct FieldReader<3, Endian::BIG> {
+  static inline uint32_t read(const uint8_t *p) { return read_uint24_be(p); }
+};
+template<> struct FieldReader<4, Endian::BIG> {
+  static inline uint32_t read(const uint8_t *p) { return read_uint32_be(p); }
+};
+template<> struct FieldReader<2, Endian::LITTLE> {
+  static inline uint32_t read(const uint8_t *p) { return read_uint16_le(p); }
+};
+template<> struct FieldReader<4, Endian::LITTLE> {
+  static inline uint32_t read(const uint8_t *p) { return read_uint32_le(p); }
+};
+
+/**
+ * One field of a frame: Width bytes at Offset, value = raw * Mul / Div.
+ * raw() is the unscaled integer, scaled() the integer-scaled value and
+ * value() the scaled value as float (e.g. flow ÷100 = GPM).
+ */
+template<uint8_t Offset, uint8_t Width = 1, Endian E = Endian::BIG, uint16_t Mul = 1, uint16_t Div = 1>
+struct Field {
+  static_assert(Width >= 1 && Width <= 4, "Fields are 1 to 4 bytes wide");
+  static_assert(Mul != 0 && Div != 0, "Field scale must be non-zero");
+
+  static constexpr uint8_t OFFSET = Offset;
+  static constexpr uint8_t WIDTH = Width;
+  static constexpr uint8_t END = Offset + Width;
+
+  static inline uint32_t raw(const uint8_t *frame) { return FieldReader<Width, E>::read(frame + Offset); }
+  static inline uint32_t scaled(const uint8_t *frame) { return raw(frame) * Mul / Div; }
+  static inline float value(const uint8_t *frame) { return (raw(frame) * Mul) / static_cast<float>(Div); }
+};
+
+// Count consecutive one-byte entries starting at Offset, each scaled by Mul
+template<uint8_t Offset, uint8_t Count, uint16_t Mul = 1> struct ByteArray {
+  static constexpr uint8_t OFFSET = Offset;
+  static constexpr uint8_t COUNT = Count;
+  static constexpr uint8_t END = Offset + Count;
+
+  static inline float value(const uint8_t *frame, size_t i) {
+    return static_cast<float>(frame[Offset + i] * Mul);
+  }
+};
+
+// Header bytes "tt".."xx" form one contiguous range
+static const uint8_t HEADER_FIRST = 0x74;
+static const uint8_t HEADER_LAST = 0x78;
+
+static inline bool is_header_byte(uint8_t b) { return static_cast<uint8_t>(b - HEADER_FIRST) <= HEADER_LAST - HEADER_FIRST; }
+
+/**
+ * Frame envelope: 2-byte repeated header, packet number at offset 2,
+ * payload from offset 3 and an optional end marker in the last byte.
+ */
+template<uint8_t Header, uint8_t Number, uint8_t Length, uint8_t EndMarker = 0> struct Frame {
+  static_assert(Length >= 3 && Length <= MAX_FRAME_LENGTH, "Frames fit a single 20-byte notification");
+
+  static constexpr uint8_t HEADER = Header;
+  static constexpr uint8_t NUMBER = Number;
+  static constexpr uint8_t LENGTH = Length;
+  static constexpr uint8_t END_MARKER = EndMarker;
+  static constexpr uint8_t PAYLOAD_BEGIN = 3;
+  // The marker byte is not payload
+  static constexpr uint8_t PAYLOAD_END = EndMarker != 0 ? Length - 1 : Length;
+};
+
+// True when layout L ends in its marker at byte Offset, outside the payload
+template<typename L> constexpr bool marker_at(uint8_t offset) {
+  return L::END_MARKER != 0 && L::LENGTH == offset + 1 && L::PAYLOAD_END == offset &&
+         L::PAYLOAD_BEGIN == wire::PAYLOAD_OFFSET;
+}
+
+// True when every field starts after the packet number and ends by byte Limit
+template<uint8_t Limit> constexpr bool fields_within() { return true; }
+template<uint8_t Limit, typename F, typename... Rest> constexpr bool fields_within() {
+  return F::OFFSET >= wire::PAYLOAD_OFFSET && F::END <= Limit && fields_within<Limit, Rest...>();
+}
+
+// True when every field lies inside the payload of layout L
+template<typename L, typename... Fields> constexpr bool fields_fit() {
+  return fields_within<L::PAYLOAD_END, Fields...>();
+}
+
+// tt: Handshake (18 bytes, no end marker; dispatched on any packet number)
+struct TT : Frame<0x74, 0, 18> {
+  using FirmwareMajor = Field<5>;
+  using FirmwareMinor = Field<6>;  // BCD
+  using AuthFlag = Field<7>;
+  using ConnectionCounter = Field<11>;
+};
+static_assert(TT::LENGTH == wire::HANDSHAKE_LENGTH, "tt responses are 18 bytes");
+static_assert(fields_fit<TT, TT::FirmwareMajor, TT::FirmwareMinor, TT::AuthFlag, TT::ConnectionCounter>(),
+              "tt field outside frame");
+
+// uu-0: Real-time status
+struct UU0 : Frame<0x75, 0, 20, END_MARKER_UU_0> {
+  using Hour = Field<3>;
+  using Minute = Field<4>;
+  using AmPm = Field<5>;
+  using Battery = Field<6>;
+  using CurrentFlow = Field<7, 2, Endian::BIG, 1, 100>;  // GPM
+  using SoftWaterRemaining = Field<9, 2>;                // gallons
+  using UsageToday = Field<11, 2>;                       // gallons
+  using PeakFlowToday = Field<13, 2, Endian::BIG, 1, 100>;  // GPM
+  using Hardness = Field<15>;                            // GPG
+  using RegenHour = Field<16>;
+  using RegenAmPm = Field<17>;
+  using Flags = Field<18>;
+};
+static_assert(marker_at<UU0>(wire::MARKER_OFFSET), "uu-0 end marker must be at byte 19");
+static_assert(fields_fit<UU0, UU0::Hour, UU0::Minute, UU0::AmPm, UU0::Battery, UU0::CurrentFlow,
+                         UU0::SoftWaterRemaining, UU0::UsageToday, UU0::PeakFlowToday, UU0::Hardness,
+                         UU0::RegenHour, UU0::RegenAmPm, UU0::Flags>(),
+              "uu-0 field outside payload");
+
+// uu-1: Brine tank & regen status
+struct UU1 : Frame<0x75, 1, 20, END_MARKER_UU_1> {
+  using FilterBackwashDays = Field<3>;
+  using AirRechargeDays = Field<4>;
+  using PositionTime = Field<5>;
+  using PositionOptionSeconds = Field<6>;
+  using RegenPosition = Field<7>;
+  using RegenActive = Field<8>;
+  using RegensRemaining = Field<13>;  // 0xFF = not configured
+  using LowSaltAlert = Field<14>;
+  using TankType = Field<15>;         // diameter, inches
+  using FillHeight = Field<16>;       // inches
+  using RefillTime = Field<17>;       // minutes
+};
+static_assert(marker_at<UU1>(wire::MARKER_OFFSET), "uu-1 end marker must be at byte 19");
+static_assert(fields_fit<UU1, UU1::FilterBackwashDays, UU1::AirRechargeDays, UU1::PositionTime,
+                         UU1::PositionOptionSeconds, UU1::RegenPosition, UU1::RegenActive,
+                         UU1::RegensRemaining, UU1::LowSaltAlert, UU1::TankType, UU1::FillHeight,
+                         UU1::RefillTime>(),
+              "uu-1 field outside payload");
+
+/**
+ * Headerless continuation segment: Length bytes on the wire, Count data bytes
+ * at offset 0 landing at record offset Start, and an optional end marker in
+ * the last byte. The frame that opens the sequence contributes record bytes
+ * 0..Start of the first continuation.
+ */
+template<uint8_t Length, uint8_t Count, uint8_t Start, uint8_t EndMarker = 0, uint16_t Mul = 1>
+struct Continuation {
+  static_assert(Length <= MAX_FRAME_LENGTH, "Continuations fit a single 20-byte notification");
+  static_assert(Count + (EndMarker != 0 ? 1 : 0) <= Length, "Continuation data exceeds its segment");
+  static constexpr uint8_t LENGTH = Length;
+  static constexpr uint8_t START = Start;
+  static constexpr uint8_t END_MARKER = EndMarker;
+  using Data = ByteArray<0, Count, Mul>;
+};
+
+// uu-2: Start of the dashboard history, followed by uu-3, uu-4 and uu-5 as
+// headerless 20-byte continuations. Every segment ends in its own marker, so
+// the 16 + 3 × 19 payload bytes are kept as one raw record.
+static const uint8_t STATUS_HISTORY_BYTES = 73;
+struct UU2 : Frame<0x75, 2, 20, END_MARKER_UU_2> {
+  using History = ByteArray<3, 16>;
+};
+static_assert(marker_at<UU2>(wire::MARKER_OFFSET), "uu-2 end marker must be at byte 19");
+static_assert(fields_fit<UU2, UU2::History>(), "uu-2 field outside payload");
+
+using UU3 = Continuation<20, 19, UU2::History::COUNT, END_MARKER_UU_3>;
+using UU4 = Continuation<20, 19, UU3::START + UU3::Data::COUNT, END_MARKER_UU_4>;
+using UU5 = Continuation<20, 19, UU4::START + UU4::Data::COUNT, END_MARKER_UU_5>;
+static_assert(UU3::LENGTH == wire::MARKER_OFFSET + 1 && UU3::Data::END <= wire::MARKER_OFFSET &&
+                  UU4::LENGTH == wire::MARKER_OFFSET + 1 && UU4::Data::END <= wire::MARKER_OFFSET &&
+                  UU5::LENGTH == wire::MARKER_OFFSET + 1 && UU5::Data::END <= wire::MARKER_OFFSET,
+              "uu-3..uu-5 data must end before the marker at byte 19");
+static_assert(UU5::START + UU5::Data::COUNT == STATUS_HISTORY_BYTES,
+              "uu-2 and its continuations must fill the status history record");
+
+// vv-0: Configuration
+struct VV0 : Frame<0x76, 0, 20, END_MARKER_VV_0> {
+  using DaysUntilRegen = Field<3>;
+  using RegenDayOverride = Field<4>;
+  using ReserveCapacity = Field<5>;                          // percent
+  using ResinCapacity = Field<6, 2, Endian::BIG, 1000, 1>;   // grains (raw in thousands)
+  using RentalRegen = Field<8>;                              // == 11 means disabled
+  using RentalUnit = Field<9>;
+  using AirRechargeFrequency = Field<10>;
+  using RegenActive = Field<11>;
+  using PrefillEnabled = Field<12>;
+  using SoakDuration = Field<13>;                            // hours
+  using PrefillSoakMode = Field<14>;                         // & 0x08
+  using Flags = Field<16>;
+};
+static_assert(marker_at<VV0>(wire::MARKER_OFFSET), "vv-0 end marker must be at byte 19");
+static_assert(fields_fit<VV0, VV0::DaysUntilRegen, VV0::RegenDayOverride, VV0::ReserveCapacity,
+                         VV0::ResinCapacity, VV0::RentalRegen, VV0::RentalUnit, VV0::AirRechargeFrequency,
+                         VV0::RegenActive, VV0::PrefillEnabled, VV0::SoakDuration, VV0::PrefillSoakMode,
+                         VV0::Flags>(),
+              "vv-0 field outside payload");
+
+// vv-1: Cycle times, one byte per position (0x80 = fixed, value & 0x7F = minutes)
+struct VV1 : Frame<0x76, 1, 20, END_MARKER_VV_1> {
+  using Positions = ByteArray<3, 8>;
+  static constexpr uint8_t FIXED_BIT = 0x80;
+};
+static_assert(marker_at<VV1>(wire::MARKER_OFFSET), "vv-1 end marker must be at byte 19");
+static_assert(fields_fit<VV1, VV1::Positions>(), "vv-1 field outside payload");
+
+// ww-0: Totals & counters (19 bytes, marker at offset 18)
+struct WW0 : Frame<0x77, 0, 19, END_MARKER_WW_0> {
+  using CurrentFlow = Field<3, 2, Endian::BIG, 1, 100>;  // GPM
+  using TotalGallons = Field<5, 3>;
+  using TotalGallonsResettable = Field<8, 3>;
+  using TotalRegens = Field<11, 2>;
+  using TotalRegensResettable = Field<13, 2>;
+  using RegenActive = Field<15>;
+};
+static_assert(marker_at<WW0>(wire::WW0_MARKER_OFFSET), "ww-0 end marker must be at byte 18");
+static_assert(fields_fit<WW0, WW0::CurrentFlow, WW0::TotalGallons, WW0::TotalGallonsResettable,
+                         WW0::TotalRegens, WW0::TotalRegensResettable, WW0::RegenActive>(),
+              "ww-0 field outside payload");
+
+// ww-1: First 17 days of usage history, followed by three headerless
+// continuations of 20, 20 and 5 (+ 0x38 marker) days. Each byte × 10 = gallons.
+static const uint8_t DAILY_USAGE_DAYS = 62;
+static const uint16_t DAILY_USAGE_SCALE = 10;
+struct WW1 : Frame<0x77, 1, 20> {
+  using History = ByteArray<3, 17, DAILY_USAGE_SCALE>;
+};
+static_assert(WW1::LENGTH == wire::NOTIFICATION_LENGTH, "ww-1 fills a whole notification");
+static_assert(fields_fit<WW1, WW1::History>(), "ww-1 field outside frame");
+
+using WW1Cont1 = Continuation<20, 20, WW1::History::COUNT, 0, DAILY_USAGE_SCALE>;
+using WW1Cont2 = Continuation<20, 20, WW1Cont1::START + WW1Cont1::Data::COUNT, 0, DAILY_USAGE_SCALE>;
+using WW1Cont3 = Continuation<6, 5, WW1Cont2::START + WW1Cont2::Data::COUNT, END_MARKER_WW_1_END, DAILY_USAGE_SCALE>;
+static_assert(WW1Cont1::LENGTH == wire::NOTIFICATION_LENGTH && WW1Cont2::LENGTH == wire::NOTIFICATION_LENGTH,
+              "ww-1 continuations 1 and 2 fill a whole notification");
+static_assert(WW1Cont3::LENGTH == wire::WW1_TAIL_LENGTH && WW1Cont3::Data::END == wire::WW1_TAIL_LENGTH - 1,
+              "ww-1 tail must end in its marker");
+static_assert(WW1Cont3::START + WW1Cont3::Data::COUNT == DAILY_USAGE_DAYS,
+              "ww-1 and its continuations must cover the full daily usage history");
+
+// Largest record assembled from a continuation sequence
+static const uint8_t MAX_RECORD_LENGTH = STATUS_HISTORY_BYTES > DAILY_USAGE_DAYS ? STATUS_HISTORY_BYTES : DAILY_USAGE_DAYS;
+
+// ww-2 / ww-3: Peak flow and regeneration history. The APK only names them
+// "history arrays"; the layout below assumes the documented 'H'/'I' markers at
+// offset 19 and 16 one-byte entries in between. Entries are kept unscaled until
+// the units are confirmed against a device. The markers are checked by the
+// decoders rather than the frame table, so a different layout is skipped
+// without losing frame sync.
+static const uint8_t HISTORY_ENTRIES = 16;
+struct WW2 : Frame<0x77, 2, 20> {
+  using PeakFlow = ByteArray<3, HISTORY_ENTRIES>;
+  static constexpr uint8_t MARKER = END_MARKER_WW_2;
+};
+static_assert(fields_within<wire::MARKER_OFFSET, WW2::PeakFlow>(), "ww-2 field overlaps the marker at byte 19");
+
+struct WW3 : Frame<0x77, 3, 20> {
+  using Regens = ByteArray<3, HISTORY_ENTRIES>;
+  static constexpr uint8_t MARKER = END_MARKER_WW_3;
+};
+static_assert(fields_within<wire::MARKER_OFFSET, WW3::Regens>(), "ww-3 field overlaps the marker at byte 19");
+
+}  // namespace frames
+}  // namespace culligan_water_softener
+}  // namespace esphome
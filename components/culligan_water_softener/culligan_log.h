@@ -0,0 +1,45 @@
+/**
+ * Culligan Water Softener steady-state logging
+ *
+ * Per-poll logging, compiled in or out per subsystem: FRAMES for notification
+ * receipts, data requests and the per-frame decoder summaries, FLAGS for the
+ * uu-0/vv-0 flag byte, HISTORY for the usage history and its statistics.
+ * quiet_decode in YAML adds the build flag -DCULLIGAN_QUIET_DECODE, which
+ * turns all three off; each can also be set to 0 on its own. Warnings are
+ * never gated. The macros log under the including file's TAG.
+ */
+
+#pragma once
+
+#include "esphome/core/log.h"
+
+#ifdef CULLIGAN_QUIET_DECODE
+#define CULLIGAN_LOG_FRAMES 0
+#define CULLIGAN_LOG_FLAGS 0
+#define CULLIGAN_LOG_HISTORY 0
+#endif
+#ifndef CULLIGAN_LOG_FRAMES
+#define CULLIGAN_LOG_FRAMES 1
+#endif
+#ifndef CULLIGAN_LOG_FLAGS
+#define CULLIGAN_LOG_FLAGS 1
+#endif
+#ifndef CULLIGAN_LOG_HISTORY
+#define CULLIGAN_LOG_HISTORY 1
+#endif
+
+#if CULLIGAN_LOG_FRAMES
+#define FRAME_LOG(level, ...) ESP_LOG##level(TAG, __VA_ARGS__)
+#else
+#define FRAME_LOG(level, ...) do {} while (0)
+#endif
+#if CULLIGAN_LOG_FLAGS
+#define FLAGS_LOG(level, ...) ESP_LOG##level(TAG, __VA_ARGS__)
+#else
+#define FLAGS_LOG(level, ...) do {} while (0)
+#endif
+#if CULLIGAN_LOG_HISTORY
+#define HISTORY_LOG(level, ...) ESP_LOG##level(TAG, __VA_ARGS__)
+#else
+#define HISTORY_LOG(level, ...) do {} while (0)
+#endif
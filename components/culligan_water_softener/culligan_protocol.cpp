@@ -0,0 +1,2306 @@
+/**
+ * Culligan Water Softener protocol core implementation
+ *
+ * Ported from Python protocol.py to C++ for native execution
+ * Protocol uses BIG-ENDIAN for all multi-byte values
+ */
+
+#include "culligan_protocol.h"
+#include "culligan_log.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace esphome {
+namespace culligan_water_softener {
+
+using namespace frames;
+
+static const char *TAG = "culligan_water_softener";
+
+// Compile-time entity selection: code generation passes -DCULLIGAN_USE_<id> for
+// each configured registry id (a range id such as SENSOR_USAGE_STAT stands for
+// the whole range) plus -DCULLIGAN_ENTITY_SELECTION, and decoding that only
+// feeds unconfigured entities is compiled out. Without a selection everything
+// is decoded. For #if only: an undefined CULLIGAN_USE_<id> evaluates to 0 there.
+#ifdef CULLIGAN_ENTITY_SELECTION
+#define CULLIGAN_USES(id) (CULLIGAN_USE_##id)
+#else
+#define CULLIGAN_USES(id) 1
+#endif
+
+// Data request command byte per request family bit ('u', 'v', 'w')
+static const uint8_t REQUEST_COMMANDS[] = {0x75, 0x76, 0x77};
+// Write queue flow control
+static const uint8_t MAX_WRITE_ATTEMPTS = 3;
+static const uint32_t WRITE_RETRY_DELAY_MS = 50;   // Back-off after a busy/congested write
+static const uint32_t WRITE_TIMEOUT_MS = 2000;     // No completion event: treat as failed
+
+// Frames cached for warm start, in StateCache slot order
+struct CachedFrame {
+  uint8_t header;
+  uint8_t number;
+};
+static const CachedFrame CACHED_FRAMES[] = {
+  {UU0::HEADER, UU0::NUMBER}, {UU1::HEADER, UU1::NUMBER}, {VV0::HEADER, VV0::NUMBER},
+  {VV1::HEADER, VV1::NUMBER}, {WW0::HEADER, WW0::NUMBER},
+};
+static const uint32_t CACHE_SAVE_INTERVAL_MS = 300000;  // Limit flash writes to one per 5 minutes
+
+// Connection state machine timing
+static const uint32_t AUTH_SETTLE_MS = 200;           // Device needs time to process authentication
+static const uint32_t AUTH_VERIFY_TIMEOUT_MS = 5000;  // No data after auth: password rejected
+static const uint8_t MAX_AUTH_ATTEMPTS = 3;
+static const uint32_t AUTH_BACKOFF_MS = 60000;        // Pause after MAX_AUTH_ATTEMPTS rejections,
+static const uint32_t AUTH_BACKOFF_MAX_MS = 1800000;  // doubled per consecutive lockout up to 30 minutes
+// No frames for this long after the last request: cycle done
+static const uint32_t SESSION_QUIET_MS = 2000;
+static const uint32_t SEQUENCE_TIMEOUT_MS = 1000;  // Gap between continuation segments before giving up
+// Trace records: flags/length byte and a 16-bit delay ahead of the payload
+static const size_t TRACE_RECORD_HEADER = 3;
+static const size_t TRACE_MAX_PAYLOAD = 0x7F;
+static const uint8_t TRACE_WRITE = 0x80;
+static const size_t TRACE_DUMP_LINE = 32;  // Bytes per logged hex line
+static const uint32_t LINK_USAGE_WINDOW_MS = 3600000;  // Link usage sensors report per hour
+// Delay before reading back settings after a write command
+static const uint32_t WRITE_REFRESH_DELAY_MS = 500;
+
+// Allowed CRC8 polynomials (4-5 bits set)
+static const uint8_t ALLOWED_POLYNOMIALS[] = {
+  0x1E, 0x1D, 0x2D, 0x2E, 0x35, 0x36, 0x39, 0x3A, 0x3C, 0x47,
+  0x4B, 0x4D, 0x4E, 0x53, 0x55, 0x56, 0x59, 0x5A, 0x5C, 0x63,
+  0x65, 0x66, 0x69, 0x6A, 0x6C, 0x71, 0x72, 0x74, 0x78, 0x87,
+  0x8B, 0x8D, 0x8E, 0x93, 0x95, 0x96, 0x99, 0x9A, 0x9C, 0xA3,
+  0xA5, 0xA6, 0xA9, 0xAA, 0xAC, 0xB1, 0xB2, 0xB4, 0xB8, 0xC3,
+  0xC5, 0xC6, 0xC9, 0xCA, 0xCC, 0xD1, 0xD2, 0xD4, 0xD8, 0xE1,
+  0xE2, 0xE4, 0xE8, 0xF0
+};
+static const size_t NUM_POLYNOMIALS = sizeof(ALLOWED_POLYNOMIALS) / sizeof(ALLOWED_POLYNOMIALS[0]);
+
+void CulliganProtocol::setup() {
+  this->restore_state_cache();
+}
+
+void CulliganProtocol::loop() {
+  uint32_t now = millis();
+
+  // Persist the warm-start cache, rate limited to spare the flash
+  if (this->state_cache_dirty_ && (now - this->last_cache_save_time_ >= CACHE_SAVE_INTERVAL_MS)) {
+    this->last_cache_save_time_ = now;
+    this->state_cache_dirty_ = false;
+    this->state_pref_.save(&this->state_cache_);
+    ESP_LOGV(TAG, "Saved state cache");
+  }
+
+  if (now - this->link_window_start_ >= LINK_USAGE_WINDOW_MS) {
+    this->publish_link_usage(now);
+  }
+
+  // Give up on a continuation sequence whose segments stopped arriving
+  if (this->sequence_ != nullptr && now - this->sequence_time_ >= SEQUENCE_TIMEOUT_MS) {
+    this->close_sequence("timed out");
+  }
+
+  // Connection state machine timers
+  switch (this->conn_state_) {
+    case CONN_AUTH_SENT:
+      if (this->write_queue_count_ == 0 && !this->write_in_flight_) {
+        if (this->auth_acked_) {
+          // Auth write completed: let the device settle
+          this->set_conn_state(CONN_AUTH_SETTLING);
+        } else {
+          // Dropped on the link, so the device never judged the password
+          ESP_LOGW(TAG, "Authentication write failed, restarting handshake");
+          this->set_conn_state(CONN_AWAIT_HANDSHAKE);
+          this->send_handshake_request();
+        }
+      }
+      break;
+    case CONN_AUTH_SETTLING:
+      if (now - this->conn_state_time_ >= AUTH_SETTLE_MS) {
+        this->set_conn_state(CONN_VERIFYING);
+        this->last_keepalive_time_ = now;
+        this->request_data();
+      }
+      break;
+    case CONN_VERIFYING:
+      // The device silently ignores requests after a rejected password. Only
+      // reached once the auth write was acknowledged (CONN_AUTH_SENT).
+      if (this->auth_required_ && now - this->conn_state_time_ >= AUTH_VERIFY_TIMEOUT_MS) {
+        this->auth_failures_++;
+        ESP_LOGE(TAG, "No data after authentication (attempt %d/%d), check the password",
+                 this->auth_failures_, MAX_AUTH_ATTEMPTS);
+        this->status_set_warning();
+        this->clear_writes();
+        this->set_conn_state(CONN_AWAIT_HANDSHAKE);
+        if (this->auth_failures_ < MAX_AUTH_ATTEMPTS) {
+          this->send_handshake_request();
+        } else {
+          this->auth_backoff_ms_ =
+              this->auth_backoff_ms_ == 0 ? AUTH_BACKOFF_MS : std::min(this->auth_backoff_ms_ * 2, AUTH_BACKOFF_MAX_MS);
+          this->auth_retry_time_ = now + this->auth_backoff_ms_;
+          ESP_LOGE(TAG, "Authentication failed %d times, retrying in %u s", this->auth_failures_,
+                   static_cast<unsigned>(this->auth_backoff_ms_ / 1000));
+        }
+      }
+      break;
+    default:
+      break;
+  }
+
+  // Send keepalive to maintain connection (every 4 seconds)
+  if (this->session_active() && (now - this->last_keepalive_time_ >= this->keepalive_interval_ms_)) {
+    this->last_keepalive_time_ = now;
+    this->send_keepalive();
+  }
+
+  // Write queue: recover from a lost completion event, then issue the next write
+  if (this->write_in_flight_ && (now - this->write_time_ >= WRITE_TIMEOUT_MS)) {
+    ESP_LOGW(TAG, "No completion for '%c' write, retrying", this->write_queue_[0].data[0]);
+    this->on_write_complete(false);
+  }
+  this->pump_writes();
+
+  this->check_heartbeat(now);
+
+  // Per-family schedules, started 100ms after the previous batch completed.
+  // Status runs at poll_interval, or fast_poll_interval while water flows or a
+  // regen runs; statistics at statistics_interval; settings only at connect and
+  // after write commands.
+  if (this->session_active() && this->pending_requests_ == 0 && (now - this->request_time_ >= 100)) {
+    uint8_t families = 0;
+    bool active = this->flow_active_ || this->regen_active_;
+    if (now - this->last_poll_time_ >= (active ? this->fast_poll_interval_ms_ : this->poll_interval_ms_)) {
+      this->last_poll_time_ = now;
+      families |= REQUEST_STATUS;
+    }
+    if (now - this->last_statistics_time_ >= this->statistics_interval_ms_) {
+      this->last_statistics_time_ = now;
+      families |= REQUEST_STATISTICS;
+    }
+    if (this->deferred_requests_ != 0 && (now - this->deferred_request_time_ >= WRITE_REFRESH_DELAY_MS)) {
+      families |= this->deferred_requests_;
+      this->deferred_requests_ = 0;
+    }
+    if (families != 0) {
+      this->request_families(families);
+    }
+  }
+}
+
+// Ring buffer append - optimized for BLE notification sizes
+void CulliganProtocol::buffer_append(const uint8_t *data, size_t length) {
+  // The ring holds at most BUFFER_SIZE - 1 bytes; keep the newest on overflow
+  if (length >= BUFFER_SIZE) {
+    data += length - (BUFFER_SIZE - 1);
+    length = BUFFER_SIZE - 1;
+  }
+  size_t free_space = BUFFER_SIZE - 1 - this->buffer_size();
+  if (length > free_space) {
+    this->buffer_consume(length - free_space);  // Drop old data
+    this->count(DIAG_BUFFER_OVERFLOWS);
+  }
+
+  // Copy in at most two chunks (up to the end, then the wrapped remainder)
+  size_t head = this->buffer_head_;
+  size_t first = std::min(length, BUFFER_SIZE - head);
+  memcpy(&this->buffer_[head], data, first);
+  memcpy(&this->buffer_[0], data + first, length - first);
+
+  // Mirror the first MIRROR_SIZE bytes past the end so frames that wrap stay contiguous
+  if (head < MIRROR_SIZE) {
+    memcpy(&this->buffer_[BUFFER_SIZE + head], &this->buffer_[head], std::min(first, MIRROR_SIZE - head));
+  }
+  if (length > first) {
+    memcpy(&this->buffer_[BUFFER_SIZE], &this->buffer_[0], std::min(length - first, MIRROR_SIZE));
+  }
+
+  this->buffer_head_ = (head + length) & (BUFFER_SIZE - 1);
+}
+
+void CulliganProtocol::handle_notification(const uint8_t *data, uint16_t length) {
+  // Skip logging for keepalive packets (hot path optimization)
+  // Only log at VERBOSE level if explicitly enabled
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERBOSE
+  if (length < 2 || data[0] != 0x78 || data[1] != 0x78) {
+    ESP_LOGV(TAG, "RX %d bytes: %02X %02X...", length, data[0], length > 1 ? data[1] : 0);
+  }
+#endif
+
+  if (!this->trace_.empty() && !this->trace_replaying_) {
+    this->trace_record(false, data, length);
+  }
+  this->link_packets_++;
+
+  // Fast path: nearly every notification is exactly one complete frame, so
+  // decode it in place when nothing is waiting in the ring buffer
+  if (this->buffer_size() == 0 && this->decode_direct(data, length)) {
+    return;
+  }
+
+  // Fragmented or headerless data goes through the ring buffer
+  this->buffer_append(data, length);
+
+  // Try to parse complete packets from buffer
+  this->process_buffer();
+}
+
+bool CulliganProtocol::decode_direct(const uint8_t *data, uint16_t length) {
+  if (length < 3 || data[0] != data[1]) {
+    return false;
+  }
+  // Headerless continuations expected: let the ring buffer path match them
+  if (this->sequence_ != nullptr) {
+    return false;
+  }
+  const FrameSpec *spec = find_frame_spec(data[0], data[2]);
+  if (spec == nullptr || spec->length != length ||
+      (spec->end_marker != 0 && data[length - 1] != spec->end_marker)) {
+    return false;
+  }
+  this->dispatch_frame(*spec, data);
+  return true;
+}
+
+void CulliganProtocol::dispatch_frame(const FrameSpec &spec, const uint8_t *frame) {
+  this->last_frame_time_ = millis();
+  this->count(static_cast<DiagnosticCounter>(DIAG_FRAMES_HANDSHAKE + (spec.header - frames::HEADER_FIRST)));
+  this->measure_latencies(spec.header, this->last_frame_time_);
+
+  // Any u/v/w frame proves the device accepted our session
+  if (this->conn_state_ == CONN_VERIFYING && spec.header >= 0x75 && spec.header <= 0x77) {
+    ESP_LOGD(TAG, "Session verified");
+    this->set_conn_state(CONN_READY);
+    if (this->auth_failures_ > 0 || this->auth_backoff_ms_ > 0) {
+      this->auth_failures_ = 0;
+      this->auth_backoff_ms_ = 0;
+      this->status_clear_warning();
+    }
+    this->release_held_commands();
+  }
+
+  if (spec.sequence != nullptr) {
+    this->open_sequence(*spec.sequence, frame);
+  } else if (spec.handler != nullptr) {
+    (this->*spec.handler)(frame);
+    this->cache_frame(spec, frame);
+  } else {
+    ESP_LOGV(TAG, "Skipping %c%c-%d packet", frame[0], frame[1], frame[2]);
+  }
+}
+
+// Continuation sequences: segment 0 is the data carried by the headed frame,
+// the others arrive without headers, in order, and are copied behind it.
+const CulliganProtocol::SequenceSpec CulliganProtocol::STATUS_HISTORY_SEQUENCE = {
+  "uu-2..5", 4,
+  {{UU2::History::OFFSET, UU2::History::COUNT, UU2::LENGTH, UU2::END_MARKER},
+   {0, UU3::Data::COUNT, UU3::LENGTH, UU3::END_MARKER},
+   {0, UU4::Data::COUNT, UU4::LENGTH, UU4::END_MARKER},
+   {0, UU5::Data::COUNT, UU5::LENGTH, UU5::END_MARKER}},
+  &CulliganProtocol::parse_status_history,
+};
+const CulliganProtocol::SequenceSpec CulliganProtocol::DAILY_USAGE_SEQUENCE = {
+  "ww-1", 4,
+  {{WW1::History::OFFSET, WW1::History::COUNT, WW1::LENGTH, WW1::END_MARKER},
+   {0, WW1Cont1::Data::COUNT, WW1Cont1::LENGTH, WW1Cont1::END_MARKER},
+   {0, WW1Cont2::Data::COUNT, WW1Cont2::LENGTH, WW1Cont2::END_MARKER},
+   {0, WW1Cont3::Data::COUNT, WW1Cont3::LENGTH, WW1Cont3::END_MARKER}},
+  &CulliganProtocol::parse_statistics_daily_usage,
+};
+
+// Frame table: one entry per (header, packet number) with its wire length,
+// expected end marker (0 = none), continuation sequence it opens and decoder
+// (nullptr = consume silently). NUMBER_ANY matches packet numbers not listed
+// earlier for the same header.
+const CulliganProtocol::FrameSpec CulliganProtocol::FRAME_TABLE[] = {
+  {TT::HEADER, NUMBER_ANY, TT::LENGTH, TT::END_MARKER, nullptr, &CulliganProtocol::parse_handshake},
+  {UU0::HEADER, UU0::NUMBER, UU0::LENGTH, UU0::END_MARKER, nullptr, &CulliganProtocol::parse_status_realtime},
+  {UU1::HEADER, UU1::NUMBER, UU1::LENGTH, UU1::END_MARKER, nullptr, &CulliganProtocol::parse_status_brine},
+  {UU2::HEADER, UU2::NUMBER, UU2::LENGTH, UU2::END_MARKER, &STATUS_HISTORY_SEQUENCE, nullptr},
+  {0x75, NUMBER_ANY, 20, 0x00, nullptr, nullptr},                                    // unknown uu frames
+  {VV0::HEADER, VV0::NUMBER, VV0::LENGTH, VV0::END_MARKER, nullptr, &CulliganProtocol::parse_settings_config},
+  {VV1::HEADER, VV1::NUMBER, VV1::LENGTH, VV1::END_MARKER, nullptr, &CulliganProtocol::parse_settings_cycle_times},
+  {0x76, NUMBER_ANY, 20, 0x00, nullptr, nullptr},                                    // vv-2, vv-3
+  {WW0::HEADER, WW0::NUMBER, WW0::LENGTH, WW0::END_MARKER, nullptr, &CulliganProtocol::parse_statistics_totals},
+  {WW1::HEADER, WW1::NUMBER, WW1::LENGTH, WW1::END_MARKER, &DAILY_USAGE_SEQUENCE, nullptr},
+  {WW2::HEADER, WW2::NUMBER, WW2::LENGTH, WW2::END_MARKER, nullptr, &CulliganProtocol::parse_statistics_peak_flow},
+  {WW3::HEADER, WW3::NUMBER, WW3::LENGTH, WW3::END_MARKER, nullptr, &CulliganProtocol::parse_statistics_regens},
+  {0x77, NUMBER_ANY, 20, 0x00, nullptr, nullptr},                                    // unknown ww frames
+  {0x78, 0, 6, 0x00, nullptr, nullptr},                                              // xx-0
+  {0x78, NUMBER_ANY, 4, 0x00, nullptr, nullptr},                                     // xx-1..6
+};
+
+const CulliganProtocol::FrameSpec *CulliganProtocol::find_frame_spec(uint8_t header, uint8_t number) {
+  for (const auto &spec : FRAME_TABLE) {
+    if (spec.header == header && (spec.number == number || spec.number == NUMBER_ANY)) {
+      return &spec;
+    }
+  }
+  return nullptr;
+}
+
+void CulliganProtocol::measure_latencies([[maybe_unused]] uint8_t header, [[maybe_unused]] uint32_t now) {
+#if CULLIGAN_USES(SENSOR_HANDSHAKE_LATENCY)
+  // Handshake to the first data frame of the session
+  if (this->conn_state_ == CONN_VERIFYING && header != 0x74 && header != 0x78) {
+    this->publish(SENSOR_HANDSHAKE_LATENCY, static_cast<float>(now - this->handshake_time_));
+  }
+#endif
+#if CULLIGAN_USES(SENSOR_RESPONSE_LATENCY)
+  // Data request to the first frame of its family
+  uint8_t index = header - 0x75;
+  if (index < 3 && (this->awaiting_response_ & (1 << index))) {
+    this->awaiting_response_ &= ~(1 << index);
+    this->publish(static_cast<SensorId>(SENSOR_RESPONSE_LATENCY + index), static_cast<float>(now - this->response_wait_start_[index]));
+  }
+#endif
+}
+
+void CulliganProtocol::process_buffer() {
+  // Drain every complete frame, bounded so a flood of bytes cannot stall loop()
+  for (uint8_t budget = MAX_FRAMES_PER_CALL; budget > 0; budget--) {
+    if (!this->process_next_frame()) {
+      return;
+    }
+  }
+}
+
+bool CulliganProtocol::process_next_frame() {
+  size_t buf_len = this->buffer_size();
+  if (buf_len < 3) {
+    return false;  // Need header + packet number
+  }
+
+  // Contiguous view of the frame at the tail (valid for MIRROR_SIZE bytes)
+  const uint8_t *frame = this->buffer_data();
+  uint8_t type0 = frame[0];
+  const FrameSpec *spec = nullptr;
+  if (type0 == frame[1]) {
+    spec = find_frame_spec(type0, frame[2]);
+  }
+
+  if (spec != nullptr) {
+    if (buf_len < spec->length) {
+      return false;  // Wait for the rest of the frame
+    }
+
+    if (spec->end_marker != 0 && frame[spec->length - 1] != spec->end_marker) {
+      ESP_LOGW(TAG, "Invalid %c%c-%d end marker: 0x%02X (expected 0x%02X), rejecting packet",
+               type0, type0, frame[2], frame[spec->length - 1], spec->end_marker);
+      this->count(DIAG_MARKER_REJECTS);
+      // Drop the header only; the resync scan finds the next frame
+      this->buffer_consume(2);
+      return true;
+    }
+
+    this->dispatch_frame(*spec, frame);
+
+    this->buffer_consume(spec->length);
+    return true;
+  }
+
+  // Headerless continuation of the open sequence (uu-3..5, ww-1 history)
+  if (this->sequence_ != nullptr) {
+    return this->process_continuation();
+  }
+
+  // Unknown packet type - scan for next valid header
+  return this->resync();
+}
+
+size_t CulliganProtocol::find_header_pair(size_t from) const {
+  // A header is two equal bytes in HEADER_FIRST..HEADER_LAST. Testing every
+  // other byte is enough: if byte p is not a header byte, no pair starts at
+  // p - 1 or p. The ring is read as up to two contiguous runs.
+  size_t length = this->buffer_size();
+  size_t first = std::min(length, BUFFER_SIZE - this->buffer_tail_);
+  const uint8_t *run = &this->buffer_[this->buffer_tail_];
+  for (size_t p = from + 1; p < length; p += 2) {
+    uint8_t b = p < first ? run[p] : this->buffer_[p - first];
+    if (!is_header_byte(b)) {
+      continue;
+    }
+    if (this->buffer_peek(p - 1) == b) {
+      return p - 1;
+    }
+    if (p + 1 < length && this->buffer_peek(p + 1) == b) {
+      return p;
+    }
+  }
+  return length;
+}
+
+bool CulliganProtocol::resync() {
+  this->count(DIAG_RESYNCS);
+  size_t length = this->buffer_size();
+  size_t pos = this->find_header_pair(1);
+  if (pos < length) {
+    ESP_LOGV(TAG, "Resync: skipped %u bytes", (unsigned) pos);
+    this->buffer_consume(pos);
+    return true;
+  }
+
+  // No header found: keep a trailing header byte, its pair may be in the next notification
+  size_t keep = is_header_byte(this->buffer_peek(length - 1)) ? 1 : 0;
+  ESP_LOGV(TAG, "Resync: no header, dropped %u bytes", (unsigned) (length - keep));
+  this->buffer_consume(length - keep);
+  return false;
+}
+
+void CulliganProtocol::open_sequence(const SequenceSpec &sequence, const uint8_t *frame) {
+  if (this->sequence_ != nullptr) {
+    this->close_sequence("superseded");
+  }
+  const SegmentSpec &head = sequence.segments[0];
+  memcpy(this->sequence_record_, frame + head.offset, head.count);
+  this->sequence_ = &sequence;
+  this->sequence_segment_ = 1;
+  this->sequence_length_ = head.count;
+  this->sequence_time_ = millis();
+  ESP_LOGV(TAG, "Opened %s sequence, awaiting %d continuations", sequence.name, sequence.segment_count - 1);
+}
+
+bool CulliganProtocol::process_continuation() {
+  if (millis() - this->sequence_time_ >= SEQUENCE_TIMEOUT_MS) {
+    this->close_sequence("timed out");
+    return true;  // Bytes go to the resync scan
+  }
+
+  const SegmentSpec &segment = this->sequence_->segments[this->sequence_segment_];
+  if (this->buffer_size() < segment.length) {
+    return false;  // Wait for the rest of the segment
+  }
+  const uint8_t *data = this->buffer_data();
+  if (segment.end_marker != 0 && data[segment.length - 1] != segment.end_marker) {
+    // Not the segment we expect: leave the bytes to the resync scan
+    ESP_LOGW(TAG, "%s continuation %d: end marker 0x%02X (expected 0x%02X)", this->sequence_->name,
+             this->sequence_segment_, data[segment.length - 1], segment.end_marker);
+    this->count(DIAG_MARKER_REJECTS);
+    this->close_sequence("bad segment");
+    return true;
+  }
+
+  memcpy(this->sequence_record_ + this->sequence_length_, data + segment.offset, segment.count);
+  this->sequence_length_ += segment.count;
+  this->buffer_consume(segment.length);
+  this->sequence_time_ = millis();
+  this->last_frame_time_ = this->sequence_time_;
+
+  if (++this->sequence_segment_ == this->sequence_->segment_count) {
+    // Complete record: one decode for the whole sequence
+    const SequenceSpec *sequence = this->sequence_;
+    this->sequence_ = nullptr;
+    (this->*sequence->decoder)(this->sequence_record_);
+  }
+  return true;
+}
+
+void CulliganProtocol::close_sequence(const char *reason) {
+  ESP_LOGW(TAG, "%s sequence %s after %d of %d segments, discarding", this->sequence_->name, reason,
+           this->sequence_segment_, this->sequence_->segment_count);
+  this->sequence_ = nullptr;
+}
+
+void CulliganProtocol::parse_handshake(const uint8_t *frame) {
+  // Handshake packets are 18 bytes (not 20 like data packets), layout in TT
+  this->firmware_major_ = TT::FirmwareMajor::raw(frame);
+  this->firmware_minor_ = TT::FirmwareMinor::raw(frame);
+  uint8_t auth_flag = TT::AuthFlag::raw(frame);
+  this->connection_counter_ = TT::ConnectionCounter::raw(frame);
+
+  // Authentication is required for firmware < 6.0, regardless of the flag byte
+  // The flag byte (0x80) may not always be set correctly by the device
+  this->auth_required_ = (this->firmware_major_ < 6) || ((auth_flag & AUTH_REQUIRED_FLAG) != 0);
+
+  char fw_version[16];
+  snprintf(fw_version, sizeof(fw_version), "C%d.%d", this->firmware_major_, this->firmware_minor_);
+
+  ESP_LOGI(TAG, "Handshake received, firmware: %s, auth flag: 0x%02X, counter: %d, already_auth: %s",
+           fw_version, auth_flag, this->connection_counter_, this->session_active() ? "yes" : "no");
+
+  this->publish(TEXT_SENSOR_FIRMWARE_VERSION, fw_version);
+
+  // Only authenticate once per connection
+  if (this->conn_state_ != CONN_AWAIT_HANDSHAKE) {
+    ESP_LOGI(TAG, "Already authenticated, ignoring handshake");
+    return;
+  }
+  this->handshake_time_ = millis();
+
+  // Send authentication if required (firmware < 6.0)
+  if (this->auth_required_) {
+    // Failures survive reconnects: a rejected password is not retried on every
+    // new link until the back-off has passed, which starts a fresh set of attempts
+    if (this->auth_failures_ >= MAX_AUTH_ATTEMPTS) {
+      int32_t remaining = static_cast<int32_t>(this->auth_retry_time_ - this->handshake_time_);
+      if (remaining > 0) {
+        ESP_LOGW(TAG, "Authentication paused after %d failures, retrying in %u s", this->auth_failures_,
+                 static_cast<unsigned>(remaining / 1000));
+        return;
+      }
+      ESP_LOGI(TAG, "Authentication back-off over, retrying");
+      this->auth_failures_ = 0;
+    }
+    ESP_LOGI(TAG, "Sending authentication with password %d...", this->password_);
+    this->send_authentication();
+  } else {
+    // No auth needed, request data directly
+    this->set_conn_state(CONN_VERIFYING);
+    this->last_keepalive_time_ = millis();
+    this->request_data();
+  }
+}
+
+void CulliganProtocol::parse_status_realtime(const uint8_t *frame) {
+  // uu-0: Real-time data, layout in UU0 (culligan_frames.h)
+  // Read by device_time and the decode log, both of which may be compiled out
+  [[maybe_unused]] uint8_t hour = UU0::Hour::raw(frame);
+  [[maybe_unused]] uint8_t minute = UU0::Minute::raw(frame);
+  [[maybe_unused]] uint8_t am_pm = UU0::AmPm::raw(frame);
+
+  // Flow values use BIG-ENDIAN and ÷100 scaling
+  float current_flow_raw = UU0::CurrentFlow::value(frame);
+  uint16_t soft_water_raw = UU0::SoftWaterRemaining::raw(frame);
+  uint16_t usage_today_raw = UU0::UsageToday::raw(frame);
+  float peak_flow_value = UU0::PeakFlowToday::value(frame);
+
+  uint8_t hardness = UU0::Hardness::raw(frame);
+  uint8_t regen_hour = UU0::RegenHour::raw(frame);
+  uint8_t flags = UU0::Flags::raw(frame);
+
+  // Validate sensor values before publishing
+  float current_flow = this->validate_current_flow(current_flow_raw);
+  uint16_t soft_water = this->validate_soft_water_remaining(soft_water_raw);
+  uint16_t usage_today = this->validate_water_usage_today(usage_today_raw);
+  float peak_flow = this->validate_peak_flow(peak_flow_value);
+
+  // Mark that we have valid readings (for jump detection)
+  this->has_valid_readings_ = true;
+
+  // Flowing water switches the scheduler to fast status polling
+  if ((current_flow > 0.0f) != this->flow_active_) {
+    this->flow_active_ = current_flow > 0.0f;
+    ESP_LOGD(TAG, "Water flow %s, %s polling", this->flow_active_ ? "started" : "stopped",
+             this->flow_active_ ? "fast" : "normal");
+  }
+
+  // Parse flags and update binary sensors
+  this->parse_flags(flags);
+
+  // Publish sensor values (using validated values)
+#if CULLIGAN_USES(TEXT_SENSOR_DEVICE_TIME)
+  this->publish_time_12h(this->text_sensors_.get(TEXT_SENSOR_DEVICE_TIME), this->device_time_key_, hour, minute, am_pm);
+#endif
+#if CULLIGAN_USES(SENSOR_BATTERY_LEVEL)
+  // Get battery percentage using lookup table
+  this->publish(SENSOR_BATTERY_LEVEL, this->get_battery_percent(UU0::Battery::raw(frame)));
+#endif
+  this->publish(SENSOR_CURRENT_FLOW, current_flow, this->flow_deadband_);
+  this->publish(SENSOR_SOFT_WATER_REMAINING, soft_water);
+  this->publish(SENSOR_WATER_USAGE_TODAY, usage_today);
+  this->publish(SENSOR_PEAK_FLOW_TODAY, peak_flow, this->flow_deadband_);
+  this->publish(SENSOR_WATER_HARDNESS, hardness);
+#if CULLIGAN_USES(TEXT_SENSOR_REGEN_TIME)
+  this->publish_time_12h(this->text_sensors_.get(TEXT_SENSOR_REGEN_TIME), this->regen_time_key_, regen_hour, 0,
+                         UU0::RegenAmPm::raw(frame));
+#endif
+
+  // Update number entities with current device values
+  this->publish(NUMBER_HARDNESS, hardness);
+  this->publish(NUMBER_REGEN_TIME_HOUR, regen_hour);
+
+  FRAME_LOG(I, "Parsed uu-0: Time=%d:%02d %s, Flow=%.2f GPM, Soft Water=%d gal, Usage=%d gal",
+           hour, minute, am_pm ? "PM" : "AM", current_flow, soft_water, usage_today);
+
+  this->status_packet_count_++;
+}
+
+void CulliganProtocol::parse_status_brine(const uint8_t *frame) {
+  // uu-1: Brine tank & regen status, layout in UU1 (culligan_frames.h)
+  uint8_t filter_backwash_days = UU1::FilterBackwashDays::raw(frame);
+  uint8_t air_recharge_days = UU1::AirRechargeDays::raw(frame);
+  uint8_t regen_active = UU1::RegenActive::raw(frame);
+  uint8_t regens_remaining = UU1::RegensRemaining::raw(frame);
+  uint8_t low_salt_alert = UU1::LowSaltAlert::raw(frame);
+  uint8_t tank_type = UU1::TankType::raw(frame);
+  uint8_t fill_height = UU1::FillHeight::raw(frame);
+  uint8_t refill_time = UU1::RefillTime::raw(frame);
+
+  // Publish filter/air recharge days
+  this->publish(SENSOR_FILTER_BACKWASH_DAYS, filter_backwash_days);
+  this->publish(SENSOR_AIR_RECHARGE_DAYS, air_recharge_days);
+
+  // Update regen active state
+  this->regen_active_ = (regen_active != 0);
+  this->publish(BINARY_SENSOR_REGEN_ACTIVE, this->regen_active_);
+
+  // Store brine tank configuration
+  this->brine_regens_remaining_ = regens_remaining;
+  this->brine_tank_type_ = tank_type;
+  this->brine_fill_height_ = fill_height;
+  this->brine_refill_time_ = refill_time;
+  this->brine_tank_configured_ = (regens_remaining != 0xFF);
+
+  // Publish brine tank type and fill height sensors
+  this->publish(SENSOR_BRINE_TANK_TYPE, tank_type);
+  this->publish(SENSOR_BRINE_FILL_HEIGHT, fill_height);
+
+  // Update brine tank number entities with current values
+  this->publish(NUMBER_BRINE_TANK_TYPE, tank_type);
+  this->publish(NUMBER_BRINE_FILL_HEIGHT, fill_height);
+
+  // Publish low salt alert threshold
+  this->publish(SENSOR_LOW_SALT_ALERT, low_salt_alert);
+  this->publish(NUMBER_LOW_SALT_ALERT, low_salt_alert);
+
+  // Calculate and publish brine level if configured
+  [[maybe_unused]] float salt_remaining = 0.0f;
+#if CULLIGAN_USES(SENSOR_BRINE_LEVEL) || CULLIGAN_USES(SENSOR_BRINE_TANK_CAPACITY) || \
+    CULLIGAN_USES(SENSOR_BRINE_SALT_PERCENT) || CULLIGAN_USES(NUMBER_SALT_LEVEL)
+  if (this->brine_tank_configured_) {
+    salt_remaining = this->calculate_salt_remaining();
+    float tank_multiplier = this->get_tank_multiplier(tank_type);
+    float tank_capacity = fill_height * tank_multiplier;
+    int salt_percent = (tank_capacity > 0) ? (int)((salt_remaining / tank_capacity) * 100) : 0;
+    if (salt_percent > 100) salt_percent = 100;
+
+    this->publish(SENSOR_BRINE_LEVEL, salt_remaining, this->salt_deadband_);
+    this->publish(SENSOR_BRINE_TANK_CAPACITY, tank_capacity, this->salt_deadband_);
+    this->publish(SENSOR_BRINE_SALT_PERCENT, salt_percent);
+    // Update salt level number entity with current value
+    this->publish(NUMBER_SALT_LEVEL, salt_remaining);
+    FRAME_LOG(D, "Salt remaining: %.1f lbs (%.0f%%), capacity: %.1f lbs (tank=%d\", height=%d\", refill=%d min, regens=%d)",
+             salt_remaining, (float)salt_percent, tank_capacity, tank_type, fill_height, refill_time, regens_remaining);
+  } else {
+    FRAME_LOG(D, "Brine tank not configured");
+  }
+#endif
+
+  FRAME_LOG(I, "Parsed uu-1: Regen active=%d, Salt=%.1f lbs, Filter backwash=%d days, Air recharge=%d days",
+           regen_active, salt_remaining,
+           filter_backwash_days, air_recharge_days);
+
+  this->status_packet_count_++;
+}
+
+void CulliganProtocol::parse_status_history([[maybe_unused]] const uint8_t *record) {
+  // uu-2..5: Dashboard history record, reassembled from uu-2 and the
+  // headerless uu-3..5 continuations (STATUS_HISTORY_SEQUENCE)
+  this->status_packet_count_ += 4;
+#if CULLIGAN_USES(TEXT_SENSOR_STATUS_HISTORY)
+  auto *sensor = this->text_sensors_.get(TEXT_SENSOR_STATUS_HISTORY);
+  if (memcmp(this->status_history_, record, STATUS_HISTORY_BYTES) == 0 && sensor != nullptr &&
+      sensor->has_state() && !this->force_publish_) {
+    return;
+  }
+  memcpy(this->status_history_, record, STATUS_HISTORY_BYTES);
+  // Hex keeps all 73 bytes inside the 255 character state limit
+  this->publish(TEXT_SENSOR_STATUS_HISTORY, format_hex(this->status_history_, STATUS_HISTORY_BYTES));
+#endif
+  FRAME_LOG(D, "Parsed uu-2..5: %d-byte status history", STATUS_HISTORY_BYTES);
+}
+
+void CulliganProtocol::parse_settings_config(const uint8_t *frame) {
+  // vv-0: Configuration, layout in VV0 (culligan_frames.h)
+  uint8_t days_until_regen = VV0::DaysUntilRegen::raw(frame);
+  uint8_t regen_day_override = VV0::RegenDayOverride::raw(frame);
+  uint8_t reserve_capacity = VV0::ReserveCapacity::raw(frame);
+  uint16_t resin_raw = VV0::ResinCapacity::raw(frame);
+  uint32_t resin_capacity = VV0::ResinCapacity::scaled(frame);  // Grains (raw value is in thousands)
+  uint8_t rental_regen_byte = VV0::RentalRegen::raw(frame);
+  uint8_t rental_unit_byte = VV0::RentalUnit::raw(frame);
+  uint8_t air_recharge_frequency = VV0::AirRechargeFrequency::raw(frame);
+  uint8_t prefill_enabled_byte = VV0::PrefillEnabled::raw(frame);
+  uint8_t soak_duration = VV0::SoakDuration::raw(frame);
+  if (soak_duration < 1) soak_duration = 1;  // Min 1 hour
+  uint8_t prefill_soak_byte = VV0::PrefillSoakMode::raw(frame);
+  uint8_t flags = VV0::Flags::raw(frame);
+
+  // Parse rental settings
+  bool rental_regen_disabled = (rental_regen_byte == 11);
+  bool rental_unit = (rental_unit_byte != 0);
+  bool prefill_enabled = (prefill_enabled_byte != 0);
+  bool prefill_soak_mode = (prefill_soak_byte & 0x08) != 0;
+
+  this->publish(SENSOR_DAYS_UNTIL_REGEN, days_until_regen);
+  this->publish(SENSOR_REGEN_DAY_OVERRIDE, regen_day_override);
+
+  // Update regen days number entity with current value
+  this->publish(NUMBER_REGEN_DAYS, regen_day_override);
+  this->publish(SENSOR_RESERVE_CAPACITY, reserve_capacity);
+
+  // Update reserve capacity number entity with current value
+  this->publish(NUMBER_RESERVE_CAPACITY, reserve_capacity);
+  this->publish(SENSOR_RESIN_CAPACITY, resin_capacity);
+
+  // Update resin capacity number entity (in thousands, e.g., 32 = 32,000 grains)
+  this->publish(NUMBER_RESIN_CAPACITY, resin_raw);
+  this->publish(SENSOR_AIR_RECHARGE_FREQUENCY, air_recharge_frequency);
+
+  // Publish prefill duration only if prefill is enabled
+  if (this->sensors_.get(SENSOR_PREFILL_DURATION) != nullptr && prefill_enabled) {
+    // Note: prefill_duration is at different offset in Python (byte 9 for duration when enabled)
+    // But per protocol, byte 9 is rental_unit. The duration comes from elsewhere.
+    // For now, soak_duration serves this purpose
+    this->publish(SENSOR_PREFILL_DURATION, soak_duration);
+  }
+
+  this->publish(SENSOR_SOAK_DURATION, soak_duration);
+
+  // Update prefill duration number entity (0 = disabled, 1-4 = hours)
+  this->publish(NUMBER_PREFILL_DURATION, prefill_enabled ? soak_duration : 0);
+
+  // Publish binary sensors for rental/prefill settings
+  this->publish(BINARY_SENSOR_RENTAL_REGEN_DISABLED, rental_regen_disabled);
+  this->publish(BINARY_SENSOR_RENTAL_UNIT, rental_unit);
+  this->publish(BINARY_SENSOR_PREFILL_ENABLED, prefill_enabled);
+  this->publish(BINARY_SENSOR_PREFILL_SOAK_MODE, prefill_soak_mode);
+
+  // Parse flags (same as uu-0 byte 18)
+  this->parse_flags(flags);
+
+  FRAME_LOG(I, "Parsed vv-0: Days until regen=%d, Regen override=%d, Reserve=%d%%, Resin=%lu grains",
+           days_until_regen, regen_day_override, reserve_capacity, (unsigned long) resin_capacity);
+}
+
+void CulliganProtocol::parse_settings_cycle_times(const uint8_t *frame) {
+  // vv-1: Cycle times for positions 1-8, layout in VV1 (culligan_frames.h)
+  // Position 1 = backwash, 2 = brine draw, 3 = rapid rinse, 4 = brine refill
+  //
+  // Note: High bit (0x80) = fixed/non-adjustable
+  // Actual time = value & 0x7F
+  const uint8_t *positions = frame + VV1::Positions::OFFSET;
+  uint8_t backwash_raw = positions[0];
+  uint8_t brine_draw_raw = positions[1];
+  uint8_t rapid_rinse_raw = positions[2];
+  uint8_t brine_refill_raw = positions[3];
+
+  // Extract actual times (mask off fixed bit)
+  uint8_t backwash_time = backwash_raw & 0x7F;
+  uint8_t brine_draw_time = brine_draw_raw & 0x7F;
+  uint8_t rapid_rinse_time = rapid_rinse_raw & 0x7F;
+  uint8_t brine_refill_time = brine_refill_raw & 0x7F;
+
+  this->publish(SENSOR_BACKWASH_TIME, backwash_time);
+  this->publish(NUMBER_BACKWASH_TIME, backwash_time);
+  this->publish(SENSOR_BRINE_DRAW_TIME, brine_draw_time);
+  this->publish(NUMBER_BRINE_DRAW_TIME, brine_draw_time);
+  this->publish(SENSOR_RAPID_RINSE_TIME, rapid_rinse_time);
+  this->publish(NUMBER_RAPID_RINSE_TIME, rapid_rinse_time);
+  this->publish(SENSOR_BRINE_REFILL_TIME, brine_refill_time);
+  this->publish(NUMBER_BRINE_REFILL_TIME, brine_refill_time);
+
+  FRAME_LOG(D, "Settings 1: Backwash=%d min%s, Brine draw=%d min%s, Rapid rinse=%d min%s, Brine refill=%d min%s",
+           backwash_time, (backwash_raw & 0x80) ? " (fixed)" : "",
+           brine_draw_time, (brine_draw_raw & 0x80) ? " (fixed)" : "",
+           rapid_rinse_time, (rapid_rinse_raw & 0x80) ? " (fixed)" : "",
+           brine_refill_time, (brine_refill_raw & 0x80) ? " (fixed)" : "");
+
+#if CULLIGAN_USES(SENSOR_CYCLE_POSITION_5) || CULLIGAN_USES(SENSOR_CYCLE_POSITION_6) || \
+    CULLIGAN_USES(SENSOR_CYCLE_POSITION_7) || CULLIGAN_USES(SENSOR_CYCLE_POSITION_8)
+  // Cycle positions 5-8
+  uint8_t pos5_raw = positions[4];
+  uint8_t pos6_raw = positions[5];
+  uint8_t pos7_raw = positions[6];
+  uint8_t pos8_raw = positions[7];
+  uint8_t pos5_time = pos5_raw & 0x7F;
+  uint8_t pos6_time = pos6_raw & 0x7F;
+  uint8_t pos7_time = pos7_raw & 0x7F;
+  uint8_t pos8_time = pos8_raw & 0x7F;
+
+  this->publish(SENSOR_CYCLE_POSITION_5, pos5_time);
+  this->publish(SENSOR_CYCLE_POSITION_6, pos6_time);
+  this->publish(SENSOR_CYCLE_POSITION_7, pos7_time);
+  this->publish(SENSOR_CYCLE_POSITION_8, pos8_time);
+
+  FRAME_LOG(D, "Settings 1: Pos5=%d min%s, Pos6=%d min%s, Pos7=%d min%s, Pos8=%d min%s",
+           pos5_time, (pos5_raw & 0x80) ? " (fixed)" : "",
+           pos6_time, (pos6_raw & 0x80) ? " (fixed)" : "",
+           pos7_time, (pos7_raw & 0x80) ? " (fixed)" : "",
+           pos8_time, (pos8_raw & 0x80) ? " (fixed)" : "");
+#endif
+}
+
+void CulliganProtocol::parse_statistics_totals(const uint8_t *frame) {
+  // ww-0: Totals & counters, layout in WW0 (culligan_frames.h)
+
+  // Current flow (validate)
+  float current_flow = this->validate_current_flow(WW0::CurrentFlow::value(frame));
+
+  // Total gallons treated (24-bit big-endian, validate)
+  uint32_t total_gallons = this->validate_total_gallons(WW0::TotalGallons::raw(frame));
+
+  uint32_t total_gallons_resettable = WW0::TotalGallonsResettable::raw(frame);
+  uint16_t total_regens = WW0::TotalRegens::raw(frame);
+  uint16_t total_regens_resettable = WW0::TotalRegensResettable::raw(frame);
+
+  this->publish(SENSOR_CURRENT_FLOW, current_flow, this->flow_deadband_);
+  this->publish(SENSOR_TOTAL_GALLONS, total_gallons);
+  this->publish(SENSOR_TOTAL_GALLONS_RESETTABLE, total_gallons_resettable);
+  this->publish(SENSOR_TOTAL_REGENS, total_regens);
+  this->publish(SENSOR_TOTAL_REGENS_RESETTABLE, total_regens_resettable);
+
+  FRAME_LOG(I, "Parsed ww-0: Flow=%.2f GPM, Total gallons=%lu (resettable=%lu), Total regens=%d (resettable=%d)",
+           current_flow, (unsigned long) total_gallons, (unsigned long) total_gallons_resettable, total_regens,
+           total_regens_resettable);
+}
+
+void CulliganProtocol::parse_statistics_daily_usage(const uint8_t *record) {
+  // ww-1: 62-day usage history, reassembled from ww-1 and its three headerless
+  // continuations (DAILY_USAGE_SEQUENCE). Each byte × 10 = gallons for that day.
+  memcpy(this->daily_usage_data_, record, DAILY_USAGE_DAYS);
+  FRAME_LOG(D, "Parsed ww-1: %d days of usage history", DAILY_USAGE_DAYS);
+
+  // Not compiled out with the average's sensor: its validation feeds the
+  // rejects_avg_daily_usage counter
+  this->calculate_avg_daily_usage();
+#if CULLIGAN_USES(TEXT_SENSOR_USAGE_HISTORY)
+  this->publish_usage_history();
+#endif
+}
+
+void CulliganProtocol::calculate_avg_daily_usage() {
+  // Average of the non-zero days in the 31-day window (indices 31-61, the
+  // more recent half, per APK)
+  this->update_usage_windows();
+  const UsageWindow &window = this->usage_windows_[AVG_USAGE_WINDOW];
+
+  float avg_raw = 0.0f;
+  if (window.count > 0) {
+    avg_raw = static_cast<float>(window.sum) * DAILY_USAGE_SCALE / window.count;
+  }
+
+  // Validate the calculated average
+  float avg = this->validate_avg_daily_usage(avg_raw);
+
+  this->publish(SENSOR_AVG_DAILY_USAGE, avg);
+
+  HISTORY_LOG(I, "Calculated avg daily usage: %.0f gal (from %d valid days)", avg, window.count);
+}
+
+void CulliganProtocol::set_usage_stat_sensor(uint8_t days, UsageStat stat, sensor::Sensor *sensor) {
+  for (uint8_t w = 0; w < USAGE_WINDOW_COUNT; w++) {
+    if (this->usage_windows_[w].days == days) {
+      this->sensors_.add(SENSOR_USAGE_STAT + w * USAGE_STAT_COUNT + stat, sensor);
+      return;
+    }
+  }
+}
+
+void CulliganProtocol::update_usage_windows() {
+  const uint8_t *cur = this->daily_usage_data_;
+  const uint8_t *prev = this->usage_stats_data_;
+  const uint8_t last = DAILY_USAGE_DAYS - 1;  // Today, still accumulating
+
+  // The history only changes at today's entry, or shifts by one at midnight
+  int shift = -1;
+  if (this->usage_stats_valid_) {
+    if (memcmp(prev, cur, last) == 0) {
+      shift = 0;
+    } else if (memcmp(prev + 1, cur, last - 1) == 0) {
+      shift = 1;
+    }
+  }
+  if (shift == 0 && prev[last] == cur[last] && !this->force_publish_) {
+    return;  // Nothing changed
+  }
+
+  for (auto &window : this->usage_windows_) {
+    uint8_t start = DAILY_USAGE_DAYS - window.days;
+    float alpha = 2.0f / (window.days + 1);
+
+    // Min and max only need a histogram scan when their last day leaves
+    auto add = [&window](uint8_t v) {
+      if (v == 0) {
+        return;
+      }
+      window.sum += v;
+      window.histogram[v]++;
+      if (window.count++ == 0 || v < window.min) {
+        window.min = v;
+      }
+      if (v > window.max) {
+        window.max = v;
+      }
+    };
+    auto remove = [&window](uint8_t v) {
+      if (v == 0) {
+        return;
+      }
+      window.sum -= v;
+      window.histogram[v]--;
+      if (--window.count == 0) {
+        window.min = 0;
+        window.max = 0;
+        return;
+      }
+      while (window.histogram[window.min] == 0) {
+        window.min++;
+      }
+      while (window.histogram[window.max] == 0) {
+        window.max--;
+      }
+    };
+
+    if (shift < 0) {
+      // First history or an unrelated one (clock change, counters reset): rescan
+      window.sum = 0;
+      window.count = 0;
+      window.min = 0;
+      window.max = 0;
+      window.ewma = 0.0f;
+      memset(window.histogram, 0, sizeof(window.histogram));
+      bool seeded = false;
+      for (uint8_t i = start; i < DAILY_USAGE_DAYS; i++) {
+        if (cur[i] == 0) {
+          continue;
+        }
+        add(cur[i]);
+        if (i < last) {
+          window.ewma = seeded ? alpha * cur[i] + (1.0f - alpha) * window.ewma : cur[i];
+          seeded = true;
+        }
+      }
+    } else {
+      // Drop the outgoing entries, add the incoming ones
+      remove(prev[last]);
+      if (shift == 1) {
+        remove(prev[start]);
+        add(cur[last - 1]);
+        // Yesterday is complete: fold it into the EWMA
+        if (cur[last - 1] != 0) {
+          window.ewma = window.ewma == 0.0f ? cur[last - 1] : alpha * cur[last - 1] + (1.0f - alpha) * window.ewma;
+        }
+      }
+      add(cur[last]);
+    }
+
+#if CULLIGAN_USES(SENSOR_USAGE_STAT)
+    this->publish_usage_window(window);
+#endif
+  }
+
+  memcpy(this->usage_stats_data_, cur, DAILY_USAGE_DAYS);
+  this->usage_stats_valid_ = true;
+}
+
+void CulliganProtocol::publish_usage_window(const UsageWindow &window) {
+  const uint8_t first = SENSOR_USAGE_STAT + (&window - this->usage_windows_) * USAGE_STAT_COUNT;
+  bool wanted = false;
+  for (uint8_t stat = 0; stat < USAGE_STAT_COUNT; stat++) {
+    wanted |= this->sensors_.get(first + stat) != nullptr;
+  }
+  if (!wanted) {
+    return;
+  }
+
+  if (window.count == 0) {
+    return;
+  }
+  // Median: walk the histogram between min and max to the middle day(s)
+  uint8_t n = window.count;
+  uint8_t low_rank = (n - 1) / 2;
+  uint8_t high_rank = n / 2;
+  uint8_t low = 0;
+  uint8_t high = window.max;
+  uint8_t seen = 0;
+  for (uint16_t v = window.min; v <= window.max; v++) {
+    seen += window.histogram[v];
+    if (low == 0 && seen > low_rank) {
+      low = v;
+    }
+    if (seen > high_rank) {
+      high = v;
+      break;
+    }
+  }
+  float median = (low + high) / 2.0f;
+
+  this->publish(static_cast<SensorId>(first + USAGE_STAT_AVERAGE), static_cast<float>(window.sum) * DAILY_USAGE_SCALE / window.count);
+  this->publish(static_cast<SensorId>(first + USAGE_STAT_MINIMUM), static_cast<float>(window.min * DAILY_USAGE_SCALE));
+  this->publish(static_cast<SensorId>(first + USAGE_STAT_MAXIMUM), static_cast<float>(window.max * DAILY_USAGE_SCALE));
+  this->publish(static_cast<SensorId>(first + USAGE_STAT_MEDIAN), median * DAILY_USAGE_SCALE);
+  this->publish(static_cast<SensorId>(first + USAGE_STAT_EWMA), window.ewma * DAILY_USAGE_SCALE);
+}
+
+void CulliganProtocol::publish_usage_history() {
+  if (this->text_sensors_.get(TEXT_SENSOR_USAGE_HISTORY) == nullptr) {
+    return;
+  }
+
+  // Only rebuild the payload when a day changed (or the heartbeat asks for it)
+  int changed = 0;
+  for (uint8_t i = 0; i < DAILY_USAGE_DAYS; i++) {
+    if (this->daily_usage_data_[i] != this->published_usage_data_[i]) {
+      changed++;
+    }
+  }
+  if (changed == 0 && this->usage_history_published_ && !this->force_publish_) {
+    return;
+  }
+
+  memcpy(this->published_usage_data_, this->daily_usage_data_, sizeof(this->published_usage_data_));
+  this->usage_history_published_ = true;
+
+  HISTORY_LOG(D, "Publishing usage history (%d days changed)", changed);
+  this->publish(TEXT_SENSOR_USAGE_HISTORY, format_byte_list(this->daily_usage_data_, DAILY_USAGE_DAYS));
+}
+
+std::string CulliganProtocol::format_byte_list(const uint8_t *data, size_t count) {
+  // Comma-separated raw bytes: 62 x "255," fits the 255 character state limit
+  char buf[DAILY_USAGE_DAYS * 4];
+  size_t pos = 0;
+  for (size_t i = 0; i < count && i < DAILY_USAGE_DAYS; i++) {
+    pos += snprintf(buf + pos, sizeof(buf) - pos, i == 0 ? "%u" : ",%u", data[i]);
+  }
+  return std::string(buf, pos);
+}
+
+void CulliganProtocol::parse_statistics_peak_flow(const uint8_t *frame) {
+  // ww-2: Peak flow history, layout in WW2 (unconfirmed, so check the marker here)
+  if (frame[WW2::LENGTH - 1] != WW2::MARKER) {
+    FRAME_LOG(D, "Skipping ww-2 with unexpected layout (byte 19 = 0x%02X)", frame[WW2::LENGTH - 1]);
+    return;
+  }
+#if CULLIGAN_USES(TEXT_SENSOR_PEAK_FLOW_HISTORY)
+  auto *sensor = this->text_sensors_.get(TEXT_SENSOR_PEAK_FLOW_HISTORY);
+  if (memcmp(this->peak_flow_history_, frame + WW2::PeakFlow::OFFSET, WW2::PeakFlow::COUNT) == 0 &&
+      sensor != nullptr && sensor->has_state() && !this->force_publish_) {
+    return;
+  }
+  memcpy(this->peak_flow_history_, frame + WW2::PeakFlow::OFFSET, WW2::PeakFlow::COUNT);
+  this->publish(TEXT_SENSOR_PEAK_FLOW_HISTORY, format_byte_list(this->peak_flow_history_, HISTORY_ENTRIES));
+#endif
+  FRAME_LOG(D, "Parsed ww-2: %d peak flow history entries", WW2::PeakFlow::COUNT);
+}
+
+void CulliganProtocol::parse_statistics_regens(const uint8_t *frame) {
+  // ww-3: Regeneration history, layout in WW3 (unconfirmed, so check the marker here)
+  if (frame[WW3::LENGTH - 1] != WW3::MARKER) {
+    FRAME_LOG(D, "Skipping ww-3 with unexpected layout (byte 19 = 0x%02X)", frame[WW3::LENGTH - 1]);
+    return;
+  }
+#if CULLIGAN_USES(TEXT_SENSOR_REGEN_HISTORY)
+  auto *sensor = this->text_sensors_.get(TEXT_SENSOR_REGEN_HISTORY);
+  if (memcmp(this->regen_history_, frame + WW3::Regens::OFFSET, WW3::Regens::COUNT) == 0 &&
+      sensor != nullptr && sensor->has_state() && !this->force_publish_) {
+    return;
+  }
+  memcpy(this->regen_history_, frame + WW3::Regens::OFFSET, WW3::Regens::COUNT);
+  this->publish(TEXT_SENSOR_REGEN_HISTORY, format_byte_list(this->regen_history_, HISTORY_ENTRIES));
+#endif
+  FRAME_LOG(D, "Parsed ww-3: %d regeneration history entries", WW3::Regens::COUNT);
+}
+
+// ============================================================================
+// Authentication Methods
+// ============================================================================
+
+void CulliganProtocol::send_authentication() {
+  std::vector<uint8_t> auth_packet = this->build_auth_packet();
+
+  // Log the auth packet for debugging
+  char hex_str[61];  // 20 bytes * 3 chars each + null
+  for (int i = 0; i < 20; i++) {
+    snprintf(hex_str + i * 3, 4, "%02X ", auth_packet[i]);
+  }
+  ESP_LOGI(TAG, "Auth packet: %s", hex_str);
+
+  this->auth_acked_ = false;
+  this->enqueue_write(auth_packet.data(), WRITE_PRIORITY_COMMAND);
+
+  // loop() requests data once the write completes and the device has settled
+  this->set_conn_state(CONN_AUTH_SENT);
+}
+
+// ============================================================================
+// Warm-start cache
+// ============================================================================
+
+void CulliganProtocol::restore_state_cache() {
+  static_assert(sizeof(CACHED_FRAMES) / sizeof(CACHED_FRAMES[0]) == CACHED_FRAME_COUNT, "cache slot mismatch");
+  this->state_pref_ = global_preferences->make_preference<StateCache>(fnv1_hash("culligan_state") ^ this->cache_key_, true);
+
+  StateCache cache{};
+  if (!this->state_pref_.load(&cache) || cache.version != STATE_CACHE_VERSION) {
+    this->state_cache_.version = STATE_CACHE_VERSION;
+    ESP_LOGD(TAG, "No cached state");
+    return;
+  }
+  this->state_cache_ = cache;
+
+  if (cache.firmware_major != 0) {
+    this->firmware_major_ = cache.firmware_major;
+    this->firmware_minor_ = cache.firmware_minor;
+    char fw_version[16];
+    snprintf(fw_version, sizeof(fw_version), "C%d.%d", cache.firmware_major, cache.firmware_minor);
+    this->publish(TEXT_SENSOR_FIRMWARE_VERSION, fw_version);
+  }
+
+  // Replay through the normal decoders: publishes entities and restores brine
+  // configuration and validation baselines until fresh data arrives. The
+  // cached uu-0 clock is zeroed; matching its key keeps it unpublished.
+  this->device_time_key_ = 0;
+  uint8_t restored = 0;
+  for (uint8_t i = 0; i < CACHED_FRAME_COUNT; i++) {
+    if (!(cache.valid_mask & (1 << i))) {
+      continue;
+    }
+    const FrameSpec *spec = find_frame_spec(CACHED_FRAMES[i].header, CACHED_FRAMES[i].number);
+    if (spec != nullptr && spec->handler != nullptr) {
+      (this->*spec->handler)(cache.frames[i]);
+      restored++;
+    }
+  }
+  ESP_LOGI(TAG, "Restored %d cached frames", restored);
+}
+
+void CulliganProtocol::cache_frame(const FrameSpec &spec, const uint8_t *frame) {
+  for (uint8_t i = 0; i < CACHED_FRAME_COUNT; i++) {
+    if (CACHED_FRAMES[i].header != spec.header || CACHED_FRAMES[i].number != frame[2]) {
+      continue;
+    }
+    // Flow is momentary and the clock ticks every minute: restoring either would
+    // report phantom usage or a stale time, and keeping them would rewrite the
+    // cache on every frame. Zero them before comparing.
+    uint8_t cached[frames::MAX_FRAME_LENGTH];
+    memcpy(cached, frame, spec.length);
+    if (spec.header == UU0::HEADER && frame[2] == UU0::NUMBER) {
+      memset(cached + UU0::CurrentFlow::OFFSET, 0, UU0::CurrentFlow::WIDTH);
+      cached[UU0::Hour::OFFSET] = 0;
+      cached[UU0::Minute::OFFSET] = 0;
+      cached[UU0::AmPm::OFFSET] = 0;
+    } else if (spec.header == WW0::HEADER && frame[2] == WW0::NUMBER) {
+      memset(cached + WW0::CurrentFlow::OFFSET, 0, WW0::CurrentFlow::WIDTH);
+    }
+    uint8_t *slot = this->state_cache_.frames[i];
+    if ((this->state_cache_.valid_mask & (1 << i)) && memcmp(slot, cached, spec.length) == 0) {
+      return;
+    }
+    memcpy(slot, cached, spec.length);
+    this->state_cache_.valid_mask |= 1 << i;
+    this->state_cache_.firmware_major = this->firmware_major_;
+    this->state_cache_.firmware_minor = this->firmware_minor_;
+    this->state_cache_dirty_ = true;
+    return;
+  }
+}
+
+void CulliganProtocol::set_conn_state(ConnectionState state) {
+  this->conn_state_ = state;
+  this->conn_state_time_ = millis();
+}
+
+void CulliganProtocol::set_link_connected(bool connected) {
+  uint32_t now = millis();
+  if (this->link_connected_ && !connected) {
+    this->link_connected_ms_ += now - this->link_connected_since_;
+  } else if (!this->link_connected_ && connected) {
+    this->link_connected_since_ = now;
+  }
+  this->link_connected_ = connected;
+}
+
+void CulliganProtocol::publish_link_usage(uint32_t now) {
+  // Close the open interval at the window boundary
+  uint32_t connected_ms = this->link_connected_ms_;
+  if (this->link_connected_) {
+    connected_ms += now - this->link_connected_since_;
+    this->link_connected_since_ = now;
+  }
+  ESP_LOGD(TAG, "Link usage last hour: %lu s connected, %lu packets", (unsigned long) (connected_ms / 1000),
+           (unsigned long) this->link_packets_);
+  this->publish(SENSOR_CONNECTED_TIME, connected_ms / 1000.0f);
+  this->publish(SENSOR_LINK_PACKETS, static_cast<float>(this->link_packets_));
+  this->link_connected_ms_ = 0;
+  this->link_packets_ = 0;
+  this->link_window_start_ = now;
+
+#if CULLIGAN_USES(SENSOR_DIAGNOSTIC)
+  for (uint8_t i = 0; i < DIAG_COUNTER_COUNT; i++) {
+    this->publish(static_cast<SensorId>(SENSOR_DIAGNOSTIC + i), static_cast<float>(this->diagnostic_counters_[i]));
+  }
+#endif
+  memset(this->diagnostic_counters_, 0, sizeof(this->diagnostic_counters_));
+}
+
+void CulliganProtocol::trace_record(bool write, const uint8_t *data, size_t length) {
+  length = std::min(length, TRACE_MAX_PAYLOAD);
+  size_t size = TRACE_RECORD_HEADER + length;
+  size_t capacity = this->trace_.size();
+  if (size > capacity) {
+    return;
+  }
+
+  // Drop the oldest records until the new one fits
+  while (capacity - this->trace_used_ < size) {
+    size_t oldest = TRACE_RECORD_HEADER + (this->trace_[this->trace_tail_] & TRACE_MAX_PAYLOAD);
+    this->trace_tail_ = (this->trace_tail_ + oldest) % capacity;
+    this->trace_used_ -= oldest;
+  }
+
+  uint32_t now = millis();
+  uint32_t delay = std::min<uint32_t>(now - this->trace_last_time_, 0xFFFF);
+  this->trace_last_time_ = now;
+  uint8_t header[TRACE_RECORD_HEADER] = {static_cast<uint8_t>((write ? TRACE_WRITE : 0) | length),
+                                         static_cast<uint8_t>(delay), static_cast<uint8_t>(delay >> 8)};
+  this->trace_put(header, TRACE_RECORD_HEADER);
+  this->trace_put(data, length);
+}
+
+void CulliganProtocol::trace_put(const uint8_t *data, size_t length) {
+  // Copy in at most two chunks, as in buffer_append()
+  size_t capacity = this->trace_.size();
+  size_t first = std::min(length, capacity - this->trace_head_);
+  memcpy(&this->trace_[this->trace_head_], data, first);
+  memcpy(&this->trace_[0], data + first, length - first);
+  this->trace_head_ = (this->trace_head_ + length) % capacity;
+  this->trace_used_ += length;
+}
+
+void CulliganProtocol::dump_trace() {
+  if (this->trace_.empty()) {
+    ESP_LOGW(TAG, "Trace disabled, set trace_buffer_size to record one");
+    return;
+  }
+  ESP_LOGI(TAG, "Trace: %u bytes", static_cast<unsigned>(this->trace_used_));
+  size_t capacity = this->trace_.size();
+  char line[TRACE_DUMP_LINE * 2 + 1];
+  for (size_t offset = 0; offset < this->trace_used_; offset += TRACE_DUMP_LINE) {
+    size_t count = std::min(TRACE_DUMP_LINE, this->trace_used_ - offset);
+    for (size_t i = 0; i < count; i++) {
+      snprintf(line + i * 2, 3, "%02X", this->trace_[(this->trace_tail_ + offset + i) % capacity]);
+    }
+    ESP_LOGI(TAG, "Trace %04X: %s", static_cast<unsigned>(offset), line);
+  }
+  ESP_LOGI(TAG, "Trace end");
+}
+
+size_t CulliganProtocol::replay_trace(const uint8_t *data, size_t length,
+                                      const std::function<void(uint16_t delay_ms)> &advance) {
+  size_t notifications = 0;
+  bool previous_request = false;
+  this->trace_replaying_ = true;
+  for (size_t pos = 0; pos + TRACE_RECORD_HEADER <= length;) {
+    uint8_t flags = data[pos];
+    size_t payload = flags & TRACE_MAX_PAYLOAD;
+    if (pos + TRACE_RECORD_HEADER + payload > length) {
+      ESP_LOGW(TAG, "Trace truncated at offset %u", static_cast<unsigned>(pos));
+      break;
+    }
+    if (advance) {
+      advance(static_cast<uint16_t>(data[pos + 1] | (data[pos + 2] << 8)));
+    }
+    const uint8_t *record = data + pos + TRACE_RECORD_HEADER;
+    bool request = false;
+    if (!(flags & TRACE_WRITE)) {
+      this->handle_notification(record, payload);
+      notifications++;
+    } else if (payload == COMMAND_LENGTH && record[0] >= REQUEST_COMMANDS[0] &&
+               record[0] < REQUEST_COMMANDS[0] + sizeof(REQUEST_COMMANDS) &&
+               std::all_of(record, record + payload, [record](uint8_t b) { return b == record[0]; })) {
+      // A batch is written back to back, before any of its responses
+      request = true;
+      this->replay_request(record[0] - REQUEST_COMMANDS[0], !previous_request);
+    }
+    previous_request = request;
+    pos += TRACE_RECORD_HEADER + payload;
+  }
+  this->trace_replaying_ = false;
+  return notifications;
+}
+
+void CulliganProtocol::replay_request(uint8_t index, bool batch_start) {
+  uint32_t now = millis();
+  if (batch_start) {
+    // What loop() and request_families() did before queueing the batch
+    this->check_heartbeat(now);
+    this->force_publish_ = this->republish_pending_;
+    this->republish_pending_ = false;
+  }
+  // What on_write_complete() did once the request was out
+  this->response_wait_start_[index] = now;
+  this->awaiting_response_ |= 1 << index;
+}
+
+void CulliganProtocol::check_heartbeat(uint32_t now) {
+  // Heartbeat: let the next poll cycle republish unchanged values
+  if (this->heartbeat_interval_ms_ > 0 && (now - this->last_heartbeat_time_ >= this->heartbeat_interval_ms_)) {
+    this->last_heartbeat_time_ = now;
+    this->republish_pending_ = true;
+  }
+}
+
+bool CulliganProtocol::session_idle(uint32_t now) const {
+  return this->conn_state_ == CONN_READY && this->pending_requests_ == 0 && this->deferred_requests_ == 0 &&
+         this->write_queue_count_ == 0 && !this->write_in_flight_ && (now - this->last_frame_time_ >= SESSION_QUIET_MS);
+}
+
+void CulliganProtocol::reset_session() {
+  this->buffer_clear();
+  this->set_conn_state(CONN_AWAIT_HANDSHAKE);
+  this->status_packet_count_ = 0;
+  this->clear_writes();
+  this->deferred_requests_ = 0;
+  this->flow_active_ = false;
+}
+
+void CulliganProtocol::send_handshake_request() {
+  uint8_t handshake_req[20];
+  memset(handshake_req, 0x74, 20);  // 't'
+  this->enqueue_write(handshake_req, WRITE_PRIORITY_COMMAND);
+}
+
+std::vector<uint8_t> CulliganProtocol::build_auth_packet() {
+  // Build 20-byte authentication packet per PROTOCOL.md
+  std::vector<uint8_t> buffer(20, 0x74);  // Fill with 't'
+
+  // Get password bytes: [units, tens, hundreds, thousands]
+  uint16_t pw = this->password_;
+  uint8_t pwd_bytes[4];
+  pwd_bytes[3] = pw / 1000;          // thousands
+  pwd_bytes[2] = (pw / 100) % 10;    // hundreds
+  pwd_bytes[1] = (pw / 10) % 10;     // tens
+  pwd_bytes[0] = pw % 10;            // units
+
+  // Select random polynomial
+  uint8_t polynomial = this->get_random_polynomial();
+
+  // Generate random values
+  uint8_t seed = (random_uint32() % 254) + 1;      // 1-255
+  uint8_t random2 = (random_uint32() % 254) + 1;   // 1-255
+
+  // Initialize CRC8
+  CsCrc8 crc;
+  crc.set_options(polynomial, seed);
+
+  // Compute authentication values
+  uint8_t xored_random = random2 ^ seed;
+  uint8_t crc_result = crc.compute_legacy(xored_random);
+  uint8_t counter_xor = this->connection_counter_ ^ crc_result;
+
+  // Fill buffer
+  buffer[2] = 0x50;  // 'P'
+  buffer[3] = 0x41;  // 'A'
+  buffer[4] = polynomial;
+  buffer[5] = seed;
+  buffer[6] = xored_random;
+
+  // Encode password digits with chained CRC
+  buffer[7] = crc.compute_legacy(counter_xor) ^ pwd_bytes[3];
+  buffer[8] = pwd_bytes[2] ^ crc.compute_legacy(buffer[7]);
+  buffer[9] = pwd_bytes[1] ^ crc.compute_legacy(buffer[8]);
+  buffer[10] = pwd_bytes[0] ^ crc.compute_legacy(buffer[9]);
+
+  // Fill remaining bytes with random values
+  for (int i = 11; i < 20; i++) {
+    buffer[i] = (random_uint32() % 254) + 1;
+  }
+
+  ESP_LOGD(TAG, "Built auth packet with polynomial=0x%02X, seed=0x%02X", polynomial, seed);
+
+  return buffer;
+}
+
+uint8_t CulliganProtocol::get_random_polynomial() {
+  return ALLOWED_POLYNOMIALS[random_uint32() % NUM_POLYNOMIALS];
+}
+
+// ============================================================================
+// Write Commands
+// ============================================================================
+
+void CulliganProtocol::send_keepalive() {
+  // Send keepalive packet to maintain BLE connection
+  // The device disconnects after ~5 seconds of inactivity
+  // Any queued write keeps the link alive just as well
+  if (this->write_in_flight_ || this->write_queue_count_ > 0) {
+    return;
+  }
+  uint8_t keepalive[20];
+  memset(keepalive, 0x78, 20);  // 'x' - keepalive packet
+  this->enqueue_write(keepalive, WRITE_PRIORITY_KEEPALIVE);
+}
+
+void CulliganProtocol::request_data() {
+  uint32_t now = millis();
+  this->last_poll_time_ = now;
+  this->last_statistics_time_ = now;
+  this->request_families(REQUEST_ALL);
+}
+
+void CulliganProtocol::request_families(uint8_t families) {
+  // Replayed requests come from the trace (replay_request)
+  if (this->trace_replaying_) {
+    return;
+  }
+
+  // A pending heartbeat upgrades the request to a full, force-published refresh
+  this->force_publish_ = this->republish_pending_;
+  if (this->republish_pending_) {
+    families |= REQUEST_ALL;
+    this->republish_pending_ = false;
+  }
+
+  FRAME_LOG(D, "Requesting data:%s%s%s", (families & REQUEST_STATUS) ? " u" : "",
+           (families & REQUEST_SETTINGS) ? " v" : "", (families & REQUEST_STATISTICS) ? " w" : "");
+
+  // Queue one request per family not already outstanding, in u, v, w order
+  for (uint8_t i = 0; i < sizeof(REQUEST_COMMANDS); i++) {
+    uint8_t family = 1 << i;
+    if ((families & family) && !(this->pending_requests_ & family)) {
+      uint8_t cmd[20];
+      memset(cmd, REQUEST_COMMANDS[i], 20);
+      if (this->enqueue_write(cmd, WRITE_PRIORITY_REQUEST)) {
+        this->pending_requests_ |= family;
+      }
+    }
+  }
+}
+
+void CulliganProtocol::send_command(const uint8_t *cmd) {
+  // Duty-cycled or dropped link: send once the next session is verified
+  if (!this->link_connected_) {
+    if (this->held_command_count_ == HELD_COMMANDS_SIZE) {
+      ESP_LOGW(TAG, "Not connected, dropping '%c' command", cmd[0]);
+      return;
+    }
+    memcpy(this->held_commands_[this->held_command_count_++], cmd, COMMAND_LENGTH);
+    ESP_LOGD(TAG, "Not connected, holding '%c' command", cmd[0]);
+    return;
+  }
+
+  if (!this->enqueue_write(cmd, WRITE_PRIORITY_COMMAND)) {
+    return;
+  }
+
+  // Read back the settings and the family the command targets once the
+  // device has applied it
+  uint8_t family = 0;
+  if (cmd[0] == 0x75) {
+    family = REQUEST_STATUS;
+  } else if (cmd[0] == 0x77) {
+    family = REQUEST_STATISTICS;
+  }
+  this->deferred_requests_ |= REQUEST_SETTINGS | family;
+  this->deferred_request_time_ = millis();
+}
+
+// ============================================================================
+// Write Queue
+// ============================================================================
+
+bool CulliganProtocol::enqueue_write(const uint8_t *cmd, WritePriority priority) {
+  // A replay only decodes: the trace already holds what was written
+  if (this->trace_replaying_) {
+    return false;
+  }
+
+  // Requests and keepalives are idempotent: one queued copy is enough
+  if (priority != WRITE_PRIORITY_COMMAND) {
+    for (uint8_t i = 0; i < this->write_queue_count_; i++) {
+      if (memcmp(this->write_queue_[i].data, cmd, COMMAND_LENGTH) == 0) {
+        return true;
+      }
+    }
+  }
+
+  // Insert behind entries of equal or higher priority, never ahead of the in-flight write
+  uint8_t first = this->write_in_flight_ ? 1 : 0;
+  uint8_t pos = this->write_queue_count_;
+  while (pos > first && this->write_queue_[pos - 1].priority > priority) {
+    pos--;
+  }
+
+  if (this->write_queue_count_ == WRITE_QUEUE_SIZE) {
+    if (pos == WRITE_QUEUE_SIZE) {
+      ESP_LOGW(TAG, "Write queue full, dropping '%c' command", cmd[0]);
+      return false;
+    }
+    // Make room by dropping the lowest-priority entry at the tail
+    this->write_queue_count_--;
+    ESP_LOGW(TAG, "Write queue full, dropping queued '%c' command", this->write_queue_[this->write_queue_count_].data[0]);
+    this->forget_request(this->write_queue_[this->write_queue_count_]);
+  }
+
+  memmove(&this->write_queue_[pos + 1], &this->write_queue_[pos],
+          (this->write_queue_count_ - pos) * sizeof(QueuedWrite));
+  QueuedWrite &entry = this->write_queue_[pos];
+  memcpy(entry.data, cmd, COMMAND_LENGTH);
+  entry.priority = priority;
+  entry.attempts = 0;
+  this->write_queue_count_++;
+
+  this->pump_writes();
+  return true;
+}
+
+void CulliganProtocol::pump_writes() {
+  if (this->write_in_flight_ || this->write_queue_count_ == 0) {
+    return;
+  }
+  uint32_t now = millis();
+  if (static_cast<int32_t>(now - this->write_retry_time_) < 0) {
+    return;  // Backing off after a busy/congested write
+  }
+
+  QueuedWrite &head = this->write_queue_[0];
+  head.attempts++;
+  this->write_in_flight_ = true;
+  this->write_time_ = now;
+  if (!this->trace_.empty() && !this->trace_replaying_) {
+    this->trace_record(true, head.data, COMMAND_LENGTH);
+  }
+  if (!this->write_command(head.data, COMMAND_LENGTH)) {
+    // Transport refused the write (busy, congested or not connected)
+    this->on_write_complete(false);
+  }
+}
+
+void CulliganProtocol::on_write_complete(bool success) {
+  if (!this->write_in_flight_ || this->write_queue_count_ == 0) {
+    return;
+  }
+  this->write_in_flight_ = false;
+
+  QueuedWrite &head = this->write_queue_[0];
+  if (success) {
+    // Every completed write counts as link activity
+    this->last_keepalive_time_ = millis();
+    this->link_packets_++;
+    if (this->conn_state_ == CONN_AUTH_SENT && head.data[0] == 0x74) {
+      // The auth packet ('t' first) reached the device; the handshake request
+      // completed before the handshake arrived
+      this->auth_acked_ = true;
+    }
+    if (head.priority == WRITE_PRIORITY_REQUEST) {
+      // Start timing the response to this request
+      uint8_t index = head.data[0] - REQUEST_COMMANDS[0];
+      this->response_wait_start_[index] = this->last_keepalive_time_;
+      this->awaiting_response_ |= 1 << index;
+    }
+  } else {
+    this->count(DIAG_WRITE_FAILURES);
+    if (head.attempts < MAX_WRITE_ATTEMPTS) {
+      this->write_retry_time_ = millis() + WRITE_RETRY_DELAY_MS;
+      return;
+    }
+    ESP_LOGW(TAG, "Dropping '%c' command after %d failed attempts", head.data[0], head.attempts);
+  }
+
+  this->forget_request(head);
+  this->write_queue_count_--;
+  memmove(&this->write_queue_[0], &this->write_queue_[1], this->write_queue_count_ * sizeof(QueuedWrite));
+
+  // Completion-driven pipelining: start the next write right away
+  this->pump_writes();
+}
+
+void CulliganProtocol::forget_request(const QueuedWrite &entry) {
+  if (entry.priority != WRITE_PRIORITY_REQUEST) {
+    return;
+  }
+  for (uint8_t i = 0; i < sizeof(REQUEST_COMMANDS); i++) {
+    if (entry.data[0] == REQUEST_COMMANDS[i]) {
+      this->pending_requests_ &= ~(1 << i);
+    }
+  }
+  this->request_time_ = millis();
+}
+
+void CulliganProtocol::release_held_commands() {
+  uint8_t count = this->held_command_count_;
+  this->held_command_count_ = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    this->send_command(this->held_commands_[i]);
+  }
+}
+
+void CulliganProtocol::clear_writes() {
+  this->write_queue_count_ = 0;
+  this->write_in_flight_ = false;
+  this->pending_requests_ = 0;
+  this->awaiting_response_ = 0;
+}
+
+void CulliganProtocol::send_regen_now() {
+  ESP_LOGI(TAG, "Sending regen now command");
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' base
+  cmd[13] = 'R';  // 0x52
+  cmd[14] = 'N';  // 0x4E
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_regen_next() {
+  ESP_LOGI(TAG, "Sending regen next command");
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' base
+  cmd[13] = 'R';  // 0x52
+  cmd[14] = 'T';  // 0x54
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_sync_time() {
+  // Get current time from ESP32
+  time_t now = time(nullptr);
+  struct tm timeinfo;
+  localtime_r(&now, &timeinfo);
+
+  // Check if time is valid (year > 2020 means we have a real time source)
+  if (timeinfo.tm_year < 120) {  // tm_year is years since 1900, so 120 = 2020
+    ESP_LOGW(TAG, "Cannot sync time: ESP32 time not set. Add 'time:' component with 'platform: homeassistant' to your config.");
+    return;
+  }
+
+  uint8_t hour_24 = timeinfo.tm_hour;
+  uint8_t minute = timeinfo.tm_min;
+  uint8_t second = timeinfo.tm_sec;
+  uint8_t hour_12 = hour_24;
+  uint8_t am_pm = 0;
+
+  // Convert to 12-hour format
+  if (hour_24 == 0) {
+    hour_12 = 12;
+    am_pm = 0;  // AM
+  } else if (hour_24 < 12) {
+    hour_12 = hour_24;
+    am_pm = 0;  // AM
+  } else if (hour_24 == 12) {
+    hour_12 = 12;
+    am_pm = 1;  // PM
+  } else {
+    hour_12 = hour_24 - 12;
+    am_pm = 1;  // PM
+  }
+
+  ESP_LOGI(TAG, "Sending sync time: %02d:%02d:%02d (24h) -> %d:%02d:%02d %s",
+           hour_24, minute, second, hour_12, minute, second, am_pm ? "PM" : "AM");
+
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' base
+  cmd[13] = 'T';     // 0x54
+  cmd[14] = hour_12;
+  cmd[15] = minute;
+  cmd[16] = am_pm;
+  cmd[17] = second;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_reset_gallons() {
+  ESP_LOGI(TAG, "Sending reset gallons command");
+  uint8_t cmd[20];
+  memset(cmd, 0x77, 20);  // 'w' base
+  cmd[13] = 'A';  // 0x41
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_reset_regens() {
+  ESP_LOGI(TAG, "Sending reset regens command");
+  uint8_t cmd[20];
+  memset(cmd, 0x77, 20);  // 'w' base
+  cmd[13] = 'B';  // 0x42
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_display(bool on) {
+  ESP_LOGI(TAG, "Setting display %s", on ? "ON" : "OFF");
+  uint8_t cmd[20];
+  memset(cmd, 0x76, 20);  // 'v' base
+  cmd[13] = 'G';      // 0x47
+  cmd[14] = on ? 0 : 1;  // 0=on, 1=off (inverted)
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_hardness(uint8_t hardness) {
+  ESP_LOGI(TAG, "Setting hardness to %d GPG", hardness);
+  if (hardness > 99) hardness = 99;
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' base
+  cmd[13] = 'H';      // 0x48
+  cmd[14] = hardness;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_regen_time(uint8_t hour, bool is_pm) {
+  ESP_LOGI(TAG, "Setting regen time to %d %s", hour, is_pm ? "PM" : "AM");
+  if (hour < 1) hour = 1;
+  if (hour > 12) hour = 12;
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' base
+  cmd[13] = 't';      // 0x74
+  cmd[14] = hour;
+  cmd[15] = is_pm ? 1 : 0;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_reserve_capacity(uint8_t percent) {
+  ESP_LOGI(TAG, "Setting reserve capacity to %d%%", percent);
+  if (percent > 49) percent = 49;
+  uint8_t cmd[20];
+  memset(cmd, 0x76, 20);  // 'v' base
+  cmd[13] = 'B';      // 0x42
+  cmd[14] = percent;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_salt_level(float lbs) {
+  // Calculate regens remaining from pounds
+  // Use rounding (add 0.5) instead of truncation for better accuracy
+  float salt_per_regen = this->brine_refill_time_ * 1.5f;
+  uint8_t regens = 0;
+  if (salt_per_regen > 0) {
+    regens = (uint8_t)((lbs / salt_per_regen) + 0.5f);  // Round to nearest
+    if (regens > 100) regens = 100;
+  }
+
+  ESP_LOGI(TAG, "Setting salt level to %.1f lbs (%d regens, %.1f lbs/regen)", lbs, regens, salt_per_regen);
+
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' base
+  cmd[13] = 'S';      // 0x53
+  cmd[14] = regens;
+  cmd[15] = 5;        // Low alert threshold (default)
+  cmd[16] = this->brine_tank_type_;
+  cmd[17] = this->brine_fill_height_;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_regen_days(uint8_t days) {
+  ESP_LOGI(TAG, "Setting regen days to %d", days);
+  uint8_t cmd[20];
+  memset(cmd, 0x76, 20);  // 'v' = AdvancedSettings
+  cmd[13] = 'A';  // 0x41
+  cmd[14] = (days > 29) ? 29 : days;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_resin_capacity(uint16_t grains_thousands) {
+  ESP_LOGI(TAG, "Setting resin capacity to %d thousand grains", grains_thousands);
+  uint16_t value = (grains_thousands > 399) ? 399 : grains_thousands;
+  uint8_t cmd[20];
+  memset(cmd, 0x76, 20);  // 'v' = AdvancedSettings
+  cmd[13] = 'C';  // 0x43
+  cmd[14] = value / 256;
+  cmd[15] = value % 256;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_prefill(bool enable, uint8_t duration_hours) {
+  ESP_LOGI(TAG, "Setting prefill: %s, %d hours", enable ? "enabled" : "disabled", duration_hours);
+  uint8_t cmd[20];
+  memset(cmd, 0x76, 20);  // 'v' = AdvancedSettings
+  cmd[13] = 'R';  // 0x52
+  cmd[14] = 'P';  // 0x50
+  cmd[15] = enable ? 1 : 0;
+  cmd[16] = (duration_hours < 1) ? 1 : ((duration_hours > 4) ? 4 : duration_hours);
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_cycle_time(uint8_t position, uint8_t minutes) {
+  ESP_LOGI(TAG, "Setting cycle position %c to %d minutes", (char)position, minutes);
+  uint8_t cmd[20];
+  memset(cmd, 0x76, 20);  // 'v' = AdvancedSettings
+  cmd[13] = 'P';  // 0x50
+  cmd[14] = position;  // Position value (49-56 for '1'-'8')
+  cmd[15] = (minutes > 99) ? 99 : minutes;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_low_salt_alert(uint8_t threshold) {
+  ESP_LOGI(TAG, "Setting low salt alert threshold to %d", threshold);
+  // This uses the brine tank command with current values except for alert threshold
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' = Dashboard
+  cmd[13] = 'S';  // 0x53
+  cmd[14] = this->brine_regens_remaining_;
+  cmd[15] = (threshold > 100) ? 100 : threshold;
+  cmd[16] = this->brine_tank_type_;
+  cmd[17] = this->brine_fill_height_;
+  this->send_command(cmd);
+}
+
+void CulliganProtocol::send_set_brine_tank_config(uint8_t tank_type, uint8_t fill_height) {
+  ESP_LOGI(TAG, "Setting brine tank config: type=%d\", height=%d\"", tank_type, fill_height);
+  // Validate tank type (16, 18, 24, or 30 inch diameter)
+  if (tank_type != 16 && tank_type != 18 && tank_type != 24 && tank_type != 30) {
+    ESP_LOGW(TAG, "Invalid tank type %d, must be 16, 18, 24, or 30", tank_type);
+    return;
+  }
+  // Update local state
+  this->brine_tank_type_ = tank_type;
+  this->brine_fill_height_ = fill_height;
+  // Send command to device
+  uint8_t cmd[20];
+  memset(cmd, 0x75, 20);  // 'u' = Dashboard
+  cmd[13] = 'S';  // 0x53
+  cmd[14] = this->brine_regens_remaining_;
+  cmd[15] = 5;  // Low alert threshold (keep existing or default)
+  cmd[16] = tank_type;
+  cmd[17] = fill_height;
+  this->send_command(cmd);
+}
+
+// ============================================================================
+// Helper Methods
+// ============================================================================
+
+// Note: read_uint16_be, read_uint24_be, read_uint32_be, read_uint16_le, read_uint32_le
+// are inline in the header and read straight from a contiguous frame pointer
+
+float CulliganProtocol::get_battery_percent(uint8_t raw) {
+  // Battery calculation from APK's getBatteryCapacity formula
+  // Raw value is ADC reading, convert to voltage: raw * 4 * 0.002 * 11
+  float voltage = raw * 4.0f * 0.002f * 11.0f;
+
+  float battery_pct;
+  if (voltage >= 9.5f) {
+    battery_pct = 100.0f;
+  } else if (voltage >= 8.91f) {
+    battery_pct = 100.0f - ((9.5f - voltage) * 8.78f);
+  } else if (voltage >= 8.48f) {
+    battery_pct = 94.78f - ((8.91f - voltage) * 30.26f);
+  } else if (voltage >= 7.43f) {
+    battery_pct = 81.84f - ((8.48f - voltage) * 60.47f);
+  } else if (voltage >= 6.5f) {
+    battery_pct = 18.68f - ((7.43f - voltage) * 20.02f);
+  } else {
+    battery_pct = 0.0f;
+  }
+
+  // Clamp to 0-100 range
+  if (battery_pct < 0.0f) battery_pct = 0.0f;
+  if (battery_pct > 100.0f) battery_pct = 100.0f;
+
+  return battery_pct;
+}
+
+float CulliganProtocol::get_tank_multiplier(uint8_t tank_type) {
+  // Tank multipliers per PROTOCOL.md
+  switch (tank_type) {
+    case 16: return 8.1f;
+    case 18: return 10.4f;
+    case 24: return 18.6f;
+    case 30: return 29.55f;
+    default: return 8.1f;
+  }
+}
+
+float CulliganProtocol::calculate_salt_remaining() {
+  if (!this->brine_tank_configured_ || this->brine_regens_remaining_ == 0xFF) {
+    return 0.0f;
+  }
+
+  // Calculate max tank capacity based on dimensions
+  // Volume = π × r² × height, then multiply by salt density (~75 lbs/ft³)
+  // Or use the pre-calculated multiplier: capacity = fill_height × tank_multiplier
+  float tank_multiplier = this->get_tank_multiplier(this->brine_tank_type_);
+  float max_capacity = this->brine_fill_height_ * tank_multiplier;
+
+  // Salt per regen (residential) = refillTime × 1.5 lbs
+  float salt_per_regen = this->brine_refill_time_ * 1.5f;
+
+  // Salt remaining = saltPerRegen × regensRemaining
+  float salt_remaining = salt_per_regen * this->brine_regens_remaining_;
+
+  // Sanity check: salt level can't exceed tank capacity
+  // If it does, we likely have corrupt data - return last valid value
+  if (salt_remaining > max_capacity * 1.1f) {  // Allow 10% tolerance
+    ESP_LOGW(TAG, "Ignoring corrupt salt level: %.1f lbs (max capacity: %.1f lbs, regens=%d)",
+             salt_remaining, max_capacity, this->brine_regens_remaining_);
+    return this->last_valid_salt_level_;
+  }
+
+  // Store last valid value for use when corrupt data is detected
+  this->last_valid_salt_level_ = salt_remaining;
+
+  return salt_remaining;
+}
+
+void CulliganProtocol::format_time_12h(char *buf, uint8_t hour, uint8_t minute, uint8_t am_pm) {
+  snprintf(buf, TIME_TEXT_SIZE, "%d:%02d %s", hour, minute, am_pm ? "PM" : "AM");
+}
+
+void CulliganProtocol::publish_time_12h(text_sensor::TextSensor *sensor, uint32_t &key, uint8_t hour, uint8_t minute,
+                                        uint8_t am_pm) {
+  uint32_t bytes = (hour << 16) | (minute << 8) | am_pm;
+  if (sensor == nullptr || (bytes == key && !this->force_publish_)) {
+    return;
+  }
+  key = bytes;
+  char text[TIME_TEXT_SIZE];
+  format_time_12h(text, hour, minute, am_pm);
+  this->publish(sensor, text);
+}
+
+std::string CulliganProtocol::format_time_24h(uint8_t hour, uint8_t minute) {
+  char time_str[8];  // Room for out-of-range bytes, which print 3 digits
+  snprintf(time_str, sizeof(time_str), "%02d:%02d", hour, minute);
+  return std::string(time_str);
+}
+
+// ============================================================================
+// Sensor Value Validation
+// ============================================================================
+
+// Maximum reasonable values for validation
+static constexpr uint16_t MAX_WATER_USAGE_TODAY = 5000;      // 5000 gallons/day is extreme
+static constexpr uint16_t MAX_SOFT_WATER_REMAINING = 15000; // 15000 gallon capacity is very large
+static constexpr float MAX_CURRENT_FLOW = 30.0f;            // 30 GPM is high for residential
+static constexpr float MAX_PEAK_FLOW = 30.0f;               // 30 GPM max
+static constexpr uint32_t MAX_TOTAL_GALLONS = 50000000;     // 50 million lifetime gallons
+static constexpr float MAX_AVG_DAILY_USAGE = 2000.0f;       // 2000 gallons/day average
+
+// Maximum change thresholds (detect sudden jumps from corrupt data)
+static constexpr uint16_t MAX_USAGE_JUMP = 500;             // 500 gallon jump is suspicious
+static constexpr uint16_t MAX_SOFT_WATER_JUMP = 2000;       // Capacity shouldn't jump much
+static constexpr float MAX_FLOW_JUMP = 15.0f;               // 15 GPM instant change is suspicious
+
+uint16_t CulliganProtocol::validate_water_usage_today(uint16_t raw_value) {
+  // Check absolute maximum
+  if (raw_value > MAX_WATER_USAGE_TODAY) {
+    ESP_LOGW(TAG, "Rejecting errant water_usage_today: %d (max: %d), using last valid: %d",
+             raw_value, MAX_WATER_USAGE_TODAY, this->last_valid_water_usage_today_);
+    this->count(DIAG_REJECTS_WATER_USAGE_TODAY);
+    return this->last_valid_water_usage_today_;
+  }
+
+  // Check for suspicious jumps (only if we have previous valid data)
+  if (this->has_valid_readings_ && raw_value > this->last_valid_water_usage_today_) {
+    uint16_t jump = raw_value - this->last_valid_water_usage_today_;
+    if (jump > MAX_USAGE_JUMP) {
+      ESP_LOGW(TAG, "Rejecting suspicious water_usage_today jump: %d -> %d (delta: %d)",
+               this->last_valid_water_usage_today_, raw_value, jump);
+      this->count(DIAG_REJECTS_WATER_USAGE_TODAY);
+      return this->last_valid_water_usage_today_;
+    }
+  }
+
+  this->last_valid_water_usage_today_ = raw_value;
+  return raw_value;
+}
+
+uint16_t CulliganProtocol::validate_soft_water_remaining(uint16_t raw_value) {
+  if (raw_value > MAX_SOFT_WATER_REMAINING) {
+    ESP_LOGW(TAG, "Rejecting errant soft_water_remaining: %d (max: %d), using last valid: %d",
+             raw_value, MAX_SOFT_WATER_REMAINING, this->last_valid_soft_water_remaining_);
+    this->count(DIAG_REJECTS_SOFT_WATER_REMAINING);
+    return this->last_valid_soft_water_remaining_;
+  }
+
+  if (this->has_valid_readings_ && raw_value > this->last_valid_soft_water_remaining_) {
+    uint16_t jump = raw_value - this->last_valid_soft_water_remaining_;
+    if (jump > MAX_SOFT_WATER_JUMP) {
+      ESP_LOGW(TAG, "Rejecting suspicious soft_water_remaining jump: %d -> %d (delta: %d)",
+               this->last_valid_soft_water_remaining_, raw_value, jump);
+      this->count(DIAG_REJECTS_SOFT_WATER_REMAINING);
+      return this->last_valid_soft_water_remaining_;
+    }
+  }
+
+  this->last_valid_soft_water_remaining_ = raw_value;
+  return raw_value;
+}
+
+float CulliganProtocol::validate_current_flow(float raw_value) {
+  if (raw_value > MAX_CURRENT_FLOW || raw_value < 0.0f) {
+    ESP_LOGW(TAG, "Rejecting errant current_flow: %.2f, using last valid: %.2f",
+             raw_value, this->last_valid_current_flow_);
+    this->count(DIAG_REJECTS_CURRENT_FLOW);
+    return this->last_valid_current_flow_;
+  }
+
+  if (this->has_valid_readings_) {
+    float jump = raw_value - this->last_valid_current_flow_;
+    if (jump > MAX_FLOW_JUMP || jump < -MAX_FLOW_JUMP) {
+      ESP_LOGW(TAG, "Rejecting suspicious current_flow jump: %.2f -> %.2f (delta: %.2f)",
+               this->last_valid_current_flow_, raw_value, jump);
+      this->count(DIAG_REJECTS_CURRENT_FLOW);
+      return this->last_valid_current_flow_;
+    }
+  }
+
+  this->last_valid_current_flow_ = raw_value;
+  return raw_value;
+}
+
+float CulliganProtocol::validate_peak_flow(float raw_value) {
+  if (raw_value > MAX_PEAK_FLOW || raw_value < 0.0f) {
+    ESP_LOGW(TAG, "Rejecting errant peak_flow: %.2f, using last valid: %.2f",
+             raw_value, this->last_valid_peak_flow_);
+    this->count(DIAG_REJECTS_PEAK_FLOW);
+    return this->last_valid_peak_flow_;
+  }
+
+  // Peak flow should only increase or reset to 0 (new day)
+  if (this->has_valid_readings_ && raw_value > this->last_valid_peak_flow_) {
+    float jump = raw_value - this->last_valid_peak_flow_;
+    if (jump > MAX_FLOW_JUMP && this->last_valid_peak_flow_ > 0.0f) {
+      ESP_LOGW(TAG, "Rejecting suspicious peak_flow jump: %.2f -> %.2f (delta: %.2f)",
+               this->last_valid_peak_flow_, raw_value, jump);
+      this->count(DIAG_REJECTS_PEAK_FLOW);
+      return this->last_valid_peak_flow_;
+    }
+  }
+
+  this->last_valid_peak_flow_ = raw_value;
+  return raw_value;
+}
+
+uint32_t CulliganProtocol::validate_total_gallons(uint32_t raw_value) {
+  if (raw_value > MAX_TOTAL_GALLONS) {
+    ESP_LOGW(TAG, "Rejecting errant total_gallons: %lu (max: %lu), using last valid: %lu",
+             (unsigned long)raw_value, (unsigned long)MAX_TOTAL_GALLONS,
+             (unsigned long)this->last_valid_total_gallons_);
+    this->count(DIAG_REJECTS_TOTAL_GALLONS);
+    return this->last_valid_total_gallons_;
+  }
+
+  // Total gallons should only increase (monotonic counter)
+  if (this->has_valid_readings_ && raw_value < this->last_valid_total_gallons_) {
+    uint32_t decrease = this->last_valid_total_gallons_ - raw_value;
+    if (decrease > 1000) {  // Allow small decreases for legitimate resets
+      ESP_LOGW(TAG, "Rejecting suspicious total_gallons decrease: %lu -> %lu",
+               (unsigned long)this->last_valid_total_gallons_, (unsigned long)raw_value);
+      this->count(DIAG_REJECTS_TOTAL_GALLONS);
+      return this->last_valid_total_gallons_;
+    }
+  }
+
+  this->last_valid_total_gallons_ = raw_value;
+  return raw_value;
+}
+
+float CulliganProtocol::validate_avg_daily_usage(float raw_value) {
+  if (raw_value > MAX_AVG_DAILY_USAGE || raw_value < 0.0f) {
+    ESP_LOGW(TAG, "Rejecting errant avg_daily_usage: %.0f, using last valid: %.0f",
+             raw_value, this->last_valid_avg_daily_usage_);
+    this->count(DIAG_REJECTS_AVG_DAILY_USAGE);
+    return this->last_valid_avg_daily_usage_;
+  }
+
+  this->last_valid_avg_daily_usage_ = raw_value;
+  return raw_value;
+}
+
+void CulliganProtocol::parse_flags(uint8_t flags) {
+  // Flag bits per PROTOCOL.md:
+  // Bit 1 (0x01): Shutoff setting enabled
+  // Bit 2 (0x02): Bypass setting enabled
+  // Bit 3 (0x04): Shutoff state active
+  // Bit 4 (0x08): Bypass state active
+  // Bit 5 (0x10): Display off
+
+  this->current_flags_ = flags;
+
+  bool shutoff_active = (flags & 0x04) != 0;
+  bool bypass_active = (flags & 0x08) != 0;
+  bool display_off = (flags & 0x10) != 0;
+
+  this->publish(BINARY_SENSOR_SHUTOFF_ACTIVE, shutoff_active);
+  this->publish(BINARY_SENSOR_BYPASS_ACTIVE, bypass_active);
+  this->publish(BINARY_SENSOR_DISPLAY_OFF, display_off);
+
+  // Update display switch state if available
+  this->publish(this->display_switch_, !display_off);  // Invert: switch ON = display ON
+
+  FLAGS_LOG(D, "Flags: shutoff=%d, bypass=%d, display_off=%d", shutoff_active, bypass_active, display_off);
+}
+
+// ============================================================================
+// Change-only publishing
+// ============================================================================
+
+void CulliganProtocol::publish(sensor::Sensor *sensor, float value, float deadband) {
+  if (sensor == nullptr) {
+    return;
+  }
+  // Compare against the raw (pre-filter) state, which is what we last published
+  if (!this->force_publish_ && sensor->has_state() && std::fabs(sensor->raw_state - value) <= deadband) {
+    return;
+  }
+  sensor->publish_state(value);
+}
+
+void CulliganProtocol::publish(text_sensor::TextSensor *sensor, const std::string &value) {
+  if (sensor == nullptr) {
+    return;
+  }
+  if (!this->force_publish_ && sensor->has_state() && sensor->raw_state == value) {
+    return;
+  }
+  sensor->publish_state(value);
+}
+
+void CulliganProtocol::publish(text_sensor::TextSensor *sensor, const char *value) {
+  if (sensor == nullptr) {
+    return;
+  }
+  // Compared in place: a std::string is only built when the state changes
+  if (!this->force_publish_ && sensor->has_state() && sensor->raw_state == value) {
+    return;
+  }
+  sensor->publish_state(value);
+}
+
+void CulliganProtocol::publish(binary_sensor::BinarySensor *sensor, bool value) {
+  if (sensor == nullptr) {
+    return;
+  }
+  if (!this->force_publish_ && sensor->has_state() && sensor->state == value) {
+    return;
+  }
+  sensor->publish_state(value);
+}
+
+void CulliganProtocol::publish(number::Number *number, float value) {
+  if (number == nullptr) {
+    return;
+  }
+  if (!this->force_publish_ && number->has_state() && number->state == value) {
+    return;
+  }
+  number->publish_state(value);
+}
+
+void CulliganProtocol::publish(switch_::Switch *sw, bool value) {
+  if (sw == nullptr) {
+    return;
+  }
+  // Switch has no "has state" flag; the first poll cycle after boot is forced
+  if (!this->force_publish_ && sw->state == value) {
+    return;
+  }
+  sw->publish_state(value);
+}
+
+// ============================================================================
+// Button Implementations
+// ============================================================================
+
+void RegenNowButton::press_action() {
+  this->parent_->send_regen_now();
+}
+
+void RegenNextButton::press_action() {
+  this->parent_->send_regen_next();
+}
+
+void SyncTimeButton::press_action() {
+  this->parent_->send_sync_time();
+}
+
+void ResetGallonsButton::press_action() {
+  this->parent_->send_reset_gallons();
+}
+
+void ResetRegensButton::press_action() {
+  this->parent_->send_reset_regens();
+}
+
+void DumpTraceButton::press_action() {
+  this->parent_->dump_trace();
+}
+
+// ============================================================================
+// Switch Implementation
+// ============================================================================
+
+void DisplaySwitch::write_state(bool state) {
+  this->parent_->send_set_display(state);
+  this->publish_state(state);
+}
+
+// ============================================================================
+// Number Implementations
+// ============================================================================
+
+void HardnessNumber::control(float value) {
+  this->parent_->send_set_hardness((uint8_t)value);
+  this->publish_state(value);
+}
+
+void RegenTimeHourNumber::control(float value) {
+  // Assume AM for now; could be extended with separate AM/PM control
+  this->parent_->send_set_regen_time((uint8_t)value, false);
+  this->publish_state(value);
+}
+
+void ReserveCapacityNumber::control(float value) {
+  this->parent_->send_set_reserve_capacity((uint8_t)value);
+  this->publish_state(value);
+}
+
+void SaltLevelNumber::control(float value) {
+  this->parent_->send_set_salt_level(value);
+  this->publish_state(value);
+}
+
+void RegenDaysNumber::control(float value) {
+  this->parent_->send_set_regen_days((uint8_t)value);
+  this->publish_state(value);
+}
+
+void ResinCapacityNumber::control(float value) {
+  // Value is in thousands of grains (e.g., 32 = 32,000 grains)
+  this->parent_->send_set_resin_capacity((uint16_t)value);
+  this->publish_state(value);
+}
+
+void PrefillDurationNumber::control(float value) {
+  // 0 = disabled, 1-4 = duration in hours
+  bool enable = (value > 0);
+  uint8_t hours = enable ? (uint8_t)value : 1;
+  this->parent_->send_set_prefill(enable, hours);
+  this->publish_state(value);
+}
+
+void BackwashTimeNumber::control(float value) {
+  this->parent_->send_set_cycle_time(49, (uint8_t)value);  // Position '1'
+  this->publish_state(value);
+}
+
+void BrineDrawTimeNumber::control(float value) {
+  this->parent_->send_set_cycle_time(50, (uint8_t)value);  // Position '2'
+  this->publish_state(value);
+}
+
+void RapidRinseTimeNumber::control(float value) {
+  this->parent_->send_set_cycle_time(51, (uint8_t)value);  // Position '3'
+  this->publish_state(value);
+}
+
+void BrineRefillTimeNumber::control(float value) {
+  this->parent_->send_set_cycle_time(52, (uint8_t)value);  // Position '4'
+  this->publish_state(value);
+}
+
+void LowSaltAlertNumber::control(float value) {
+  this->parent_->send_set_low_salt_alert((uint8_t)value);
+  this->publish_state(value);
+}
+
+void BrineTankTypeNumber::control(float value) {
+  // Tank type must be 16, 18, 24, or 30
+  uint8_t tank_type = (uint8_t)value;
+  // Round to nearest valid value
+  if (tank_type < 17) tank_type = 16;
+  else if (tank_type < 21) tank_type = 18;
+  else if (tank_type < 27) tank_type = 24;
+  else tank_type = 30;
+  this->parent_->send_set_brine_tank_config(tank_type, this->parent_->get_brine_fill_height());
+  this->publish_state(tank_type);
+}
+
+void BrineFillHeightNumber::control(float value) {
+  this->parent_->send_set_brine_tank_config(this->parent_->get_brine_tank_type(), (uint8_t)value);
+  this->publish_state(value);
+}
+
+}  // namespace culligan_water_softener
+}  // namespace esphome
@@ -0,0 +1,827 @@
+/**
+ * Culligan Water Softener protocol core
+ *
+ * Framing, decoding and command encoding for the Culligan CS Meter Soft
+ * protocol. Contains no ESP-IDF or BLE types so it also builds off-device
+ * (host/CMakeLists.txt); the BLE transport lives in
+ * culligan_water_softener.h and feeds notifications into handle_notification().
+ *
+ * Protocol: BIG-ENDIAN for all multi-byte values
+ */
+
+#pragma once
+
+#include "culligan_frames.h"
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/button/button.h"
+#include "esphome/components/switch/switch.h"
+#include "esphome/components/number/number.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include <vector>
+
+namespace esphome {
+namespace culligan_water_softener {
+
+// Packet type identifiers
+static const uint8_t PACKET_TYPE_HANDSHAKE[] = {0x74, 0x74};  // "tt"
+static const uint8_t PACKET_TYPE_STATUS[] = {0x75, 0x75};     // "uu"
+static const uint8_t PACKET_TYPE_SETTINGS[] = {0x76, 0x76};   // "vv"
+static const uint8_t PACKET_TYPE_STATISTICS[] = {0x77, 0x77}; // "ww"
+static const uint8_t PACKET_TYPE_KEEPALIVE[] = {0x78, 0x78};  // "xx"
+
+// Request families: frame groups a data request asks the device for
+enum RequestFamily : uint8_t {
+  REQUEST_STATUS = 1 << 0,      // 'u': uu-0..5 realtime status
+  REQUEST_SETTINGS = 1 << 1,    // 'v': vv-0..3 configuration
+  REQUEST_STATISTICS = 1 << 2,  // 'w': ww-0..3 totals and usage history
+  REQUEST_ALL = REQUEST_STATUS | REQUEST_SETTINGS | REQUEST_STATISTICS,
+};
+
+// Rolling statistics reported for each usage window
+enum UsageStat : uint8_t {
+  USAGE_STAT_AVERAGE,
+  USAGE_STAT_MINIMUM,
+  USAGE_STAT_MAXIMUM,
+  USAGE_STAT_MEDIAN,
+  USAGE_STAT_EWMA,
+  USAGE_STAT_COUNT,
+};
+static const uint8_t USAGE_WINDOW_COUNT = 4;  // 7, 14, 31 and 62 days
+
+// Protocol health counters, published once per hour as diagnostic sensors
+enum DiagnosticCounter : uint8_t {
+  DIAG_FRAMES_HANDSHAKE,  // Decoded frames per header, in header order tt..xx
+  DIAG_FRAMES_STATUS,
+  DIAG_FRAMES_SETTINGS,
+  DIAG_FRAMES_STATISTICS,
+  DIAG_FRAMES_KEEPALIVE,
+  DIAG_MARKER_REJECTS,    // Frames and continuations with the wrong end marker
+  DIAG_RESYNCS,           // Scans past unrecognised bytes
+  DIAG_BUFFER_OVERFLOWS,  // Appends that dropped unread data from the ring buffer
+  DIAG_WRITE_FAILURES,    // Write attempts refused or failed by the transport
+  DIAG_REJECTS_WATER_USAGE_TODAY,  // Values rejected by validate_*()
+  DIAG_REJECTS_SOFT_WATER_REMAINING,
+  DIAG_REJECTS_CURRENT_FLOW,
+  DIAG_REJECTS_PEAK_FLOW,
+  DIAG_REJECTS_TOTAL_GALLONS,
+  DIAG_REJECTS_AVG_DAILY_USAGE,
+  DIAG_COUNTER_COUNT,
+};
+
+// Entity registry ids, one per entity the decoders publish. The platform
+// files register each configured entity under its id (see EntityRegistry).
+enum SensorId : uint8_t {
+  SENSOR_CURRENT_FLOW,
+  SENSOR_SOFT_WATER_REMAINING,
+  SENSOR_WATER_USAGE_TODAY,
+  SENSOR_PEAK_FLOW_TODAY,
+  SENSOR_WATER_HARDNESS,
+  SENSOR_BRINE_LEVEL,
+  SENSOR_AVG_DAILY_USAGE,
+  SENSOR_DAYS_UNTIL_REGEN,
+  SENSOR_TOTAL_GALLONS,
+  SENSOR_TOTAL_REGENS,
+  SENSOR_BATTERY_LEVEL,
+  SENSOR_RESERVE_CAPACITY,
+  SENSOR_RESIN_CAPACITY,
+  SENSOR_PREFILL_DURATION,
+  SENSOR_SOAK_DURATION,
+  SENSOR_BACKWASH_TIME,
+  SENSOR_BRINE_DRAW_TIME,
+  SENSOR_RAPID_RINSE_TIME,
+  SENSOR_BRINE_REFILL_TIME,
+  SENSOR_FILTER_BACKWASH_DAYS,
+  SENSOR_AIR_RECHARGE_DAYS,
+  SENSOR_LOW_SALT_ALERT,
+  SENSOR_BRINE_TANK_CAPACITY,
+  SENSOR_BRINE_SALT_PERCENT,
+  SENSOR_REGEN_DAY_OVERRIDE,
+  SENSOR_AIR_RECHARGE_FREQUENCY,
+  SENSOR_TOTAL_GALLONS_RESETTABLE,
+  SENSOR_TOTAL_REGENS_RESETTABLE,
+  SENSOR_CYCLE_POSITION_5,
+  SENSOR_CYCLE_POSITION_6,
+  SENSOR_CYCLE_POSITION_7,
+  SENSOR_CYCLE_POSITION_8,
+  SENSOR_BRINE_TANK_TYPE,
+  SENSOR_BRINE_FILL_HEIGHT,
+  SENSOR_CONNECTED_TIME,
+  SENSOR_LINK_PACKETS,
+  SENSOR_HANDSHAKE_LATENCY,
+  SENSOR_RESPONSE_LATENCY,                                   // One per request family: u, v, w
+  SENSOR_DIAGNOSTIC = SENSOR_RESPONSE_LATENCY + 3,           // One per DiagnosticCounter
+  SENSOR_USAGE_STAT = SENSOR_DIAGNOSTIC + DIAG_COUNTER_COUNT,  // USAGE_STAT_COUNT per usage window
+  SENSOR_COUNT = SENSOR_USAGE_STAT + USAGE_WINDOW_COUNT * USAGE_STAT_COUNT,
+};
+
+enum TextSensorId : uint8_t {
+  TEXT_SENSOR_FIRMWARE_VERSION,
+  TEXT_SENSOR_DEVICE_TIME,
+  TEXT_SENSOR_REGEN_TIME,
+  TEXT_SENSOR_USAGE_HISTORY,
+  TEXT_SENSOR_PEAK_FLOW_HISTORY,
+  TEXT_SENSOR_REGEN_HISTORY,
+  TEXT_SENSOR_STATUS_HISTORY,
+  TEXT_SENSOR_MAC_ADDRESS,
+  TEXT_SENSOR_COUNT,
+};
+
+enum BinarySensorId : uint8_t {
+  BINARY_SENSOR_DISPLAY_OFF,
+  BINARY_SENSOR_BYPASS_ACTIVE,
+  BINARY_SENSOR_SHUTOFF_ACTIVE,
+  BINARY_SENSOR_REGEN_ACTIVE,
+  BINARY_SENSOR_RENTAL_REGEN_DISABLED,
+  BINARY_SENSOR_RENTAL_UNIT,
+  BINARY_SENSOR_PREFILL_ENABLED,
+  BINARY_SENSOR_PREFILL_SOAK_MODE,
+  BINARY_SENSOR_COUNT,
+};
+
+enum NumberId : uint8_t {
+  NUMBER_HARDNESS,
+  NUMBER_REGEN_TIME_HOUR,
+  NUMBER_RESERVE_CAPACITY,
+  NUMBER_SALT_LEVEL,
+  NUMBER_REGEN_DAYS,
+  NUMBER_RESIN_CAPACITY,
+  NUMBER_PREFILL_DURATION,
+  NUMBER_BACKWASH_TIME,
+  NUMBER_BRINE_DRAW_TIME,
+  NUMBER_RAPID_RINSE_TIME,
+  NUMBER_BRINE_REFILL_TIME,
+  NUMBER_LOW_SALT_ALERT,
+  NUMBER_BRINE_TANK_TYPE,
+  NUMBER_BRINE_FILL_HEIGHT,
+  NUMBER_COUNT,
+};
+
+/**
+ * Entity registry: maps compile-time ids to the entities configured for them.
+ * An unconfigured id costs one byte; configured entities are kept densely.
+ */
+template<typename T, size_t N> class EntityRegistry {
+ public:
+  static_assert(N < 0xFF, "Slot indices are uint8_t");
+  EntityRegistry() { std::fill_n(this->slots_, N, NONE); }
+
+  void add(size_t id, T *entity) {
+    if (this->slots_[id] == NONE) {
+      this->slots_[id] = this->entities_.size();
+      this->entities_.push_back(entity);
+    } else {
+      this->entities_[this->slots_[id]] = entity;
+    }
+  }
+  inline T *get(size_t id) const {
+    uint8_t slot = this->slots_[id];
+    return slot == NONE ? nullptr : this->entities_[slot];
+  }
+  const std::vector<T *> &all() const { return this->entities_; }
+
+ protected:
+  static constexpr uint8_t NONE = 0xFF;
+  uint8_t slots_[N];
+  std::vector<T *> entities_;
+};
+
+// Authentication constants
+static const uint8_t AUTH_REQUIRED_FLAG = 0x80;
+static const uint16_t DEFAULT_PASSWORD = 1234;
+
+/**
+ * CRC8 implementation for authentication
+ * Matches the APK's CsCrc8 class
+ */
+class CsCrc8 {
+ public:
+  CsCrc8() : polynomial_(213), seed_(0) {}
+
+  void set_options(uint8_t polynomial, uint8_t seed) {
+    polynomial_ = polynomial;
+    seed_ = seed;
+  }
+
+  /**
+   * Compute CRC8 using the legacy algorithm.
+   * Matches CsCrc8.computeLegacy() in the APK.
+   */
+  uint8_t compute_legacy(uint8_t value) {
+    uint8_t b = value;
+    uint8_t b2 = seed_;
+
+    for (int i = 0; i < 8; i++) {
+      bool z = (b2 & 0x80) != 0;
+      b2 = (b2 << 1) & 0xFF;
+      if ((b & 0x80) != 0) {
+        b2 = (b2 | 1) & 0xFF;
+      }
+      b = (b << 1) & 0xFF;
+      if (z) {
+        b2 = (b2 ^ polynomial_) & 0xFF;
+      }
+    }
+
+    seed_ = b2;
+    return b2;
+  }
+
+  /**
+   * Compute CRC8 using the standard algorithm.
+   * Matches CsCrc8.compute(int) in the APK.
+   */
+  uint8_t compute(uint8_t value) {
+    uint8_t b = (value ^ seed_) & 0xFF;
+
+    for (int i = 0; i < 8; i++) {
+      if ((b & 0x80) > 0) {
+        b = ((b << 1) ^ polynomial_) & 0xFF;
+      } else {
+        b = (b << 1) & 0xFF;
+      }
+    }
+
+    seed_ = b;
+    return b;
+  }
+
+  uint8_t get_seed() const { return seed_; }
+
+ protected:
+  uint8_t polynomial_;
+  uint8_t seed_;
+};
+
+// Forward declarations for button classes
+class CulliganProtocol;
+
+class RegenNowButton : public button::Button, public Parented<CulliganProtocol> {
+ public:
+  void press_action() override;
+};
+
+class RegenNextButton : public button::Button, public Parented<CulliganProtocol> {
+ public:
+  void press_action() override;
+};
+
+class SyncTimeButton : public button::Button, public Parented<CulliganProtocol> {
+ public:
+  void press_action() override;
+};
+
+class ResetGallonsButton : public button::Button, public Parented<CulliganProtocol> {
+ public:
+  void press_action() override;
+};
+
+class ResetRegensButton : public button::Button, public Parented<CulliganProtocol> {
+ public:
+  void press_action() override;
+};
+
+class DumpTraceButton : public button::Button, public Parented<CulliganProtocol> {
+ public:
+  void press_action() override;
+};
+
+// Forward declaration for switch class
+class DisplaySwitch : public switch_::Switch, public Parented<CulliganProtocol> {
+ public:
+  void write_state(bool state) override;
+};
+
+// Forward declarations for number classes
+class HardnessNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class RegenTimeHourNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class ReserveCapacityNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class SaltLevelNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class RegenDaysNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class ResinCapacityNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class PrefillDurationNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class BackwashTimeNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class BrineDrawTimeNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class RapidRinseTimeNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class BrineRefillTimeNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class LowSaltAlertNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class BrineTankTypeNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+class BrineFillHeightNumber : public number::Number, public Parented<CulliganProtocol> {
+ public:
+  void control(float value) override;
+};
+
+/**
+ * Platform-independent protocol state machine
+ *
+ * Owns the notification ring buffer, packet decoders, sensor publishing and
+ * command encoding. Subclasses provide the transport by implementing
+ * write_command(), reporting completions to on_write_complete() and feeding
+ * received bytes to handle_notification().
+ */
+class CulliganProtocol : public Component {
+ public:
+  void setup() override;
+  void loop() override;
+
+  // Feed raw notification bytes from the transport into the parser
+  void handle_notification(const uint8_t *data, uint16_t length);
+  // Transport reports the outcome of the write started by write_command()
+  void on_write_complete(bool success);
+  // Transport reports the BLE link going up or down (for link usage and held commands)
+  void set_link_connected(bool connected);
+
+  // Configuration setters
+  void set_password(uint16_t password) { password_ = password; }
+  void set_poll_interval(uint32_t interval_ms) { poll_interval_ms_ = interval_ms; }
+  void set_fast_poll_interval(uint32_t interval_ms) { fast_poll_interval_ms_ = interval_ms; }
+  void set_statistics_interval(uint32_t interval_ms) { statistics_interval_ms_ = interval_ms; }
+  void set_heartbeat_interval(uint32_t interval_ms) { heartbeat_interval_ms_ = interval_ms; }
+  void set_flow_deadband(float deadband) { flow_deadband_ = deadband; }
+  void set_salt_deadband(float deadband) { salt_deadband_ = deadband; }
+  // Distinguishes the persisted caches of multiple instances
+  void set_cache_key(const std::string &key) { cache_key_ = fnv1_hash(key); }
+
+  /**
+   * Binary trace of every notification and write, kept in a circular buffer
+   * of the configured size (0 = off). Each record is one flags byte (bit 7 set
+   * for a write, bits 0-6 the payload length), the milliseconds since the
+   * previous record (uint16 LE, saturating) and the payload.
+   */
+  void set_trace_buffer_size(size_t size) { trace_.resize(size); }
+  // Log the trace as hex lines, oldest record first
+  void dump_trace();
+  // Feed the notifications of a dumped trace back through the decoder. Nothing
+  // is written meanwhile; the trace's data requests stand in for the ones the
+  // decoder would send, so heartbeat republishes and response latencies follow
+  // the recording. advance, if set, is called with each record's delay so a
+  // host build can step its clock. Returns the number of notifications fed.
+  size_t replay_trace(const uint8_t *data, size_t length,
+                      const std::function<void(uint16_t delay_ms)> &advance = nullptr);
+
+  // Entity registration by id (see SensorId etc.)
+  void set_sensor(SensorId id, sensor::Sensor *sensor) { sensors_.add(id, sensor); }
+  void set_text_sensor(TextSensorId id, text_sensor::TextSensor *sensor) { text_sensors_.add(id, sensor); }
+  void set_binary_sensor(BinarySensorId id, binary_sensor::BinarySensor *sensor) { binary_sensors_.add(id, sensor); }
+  void set_number(NumberId id, number::Number *number) { numbers_.add(id, number); }
+
+  // Rolling usage statistics over the last 7, 14, 31 or 62 days
+  void set_usage_stat_sensor(uint8_t days, UsageStat stat, sensor::Sensor *sensor);
+  // Diagnostics: hourly counters, and latencies published as they are measured
+  void set_diagnostic_counter_sensor(DiagnosticCounter counter, sensor::Sensor *sensor) {
+    sensors_.add(SENSOR_DIAGNOSTIC + counter, sensor);
+  }
+  void set_response_latency_sensor(RequestFamily family, sensor::Sensor *sensor) {
+    sensors_.add(SENSOR_RESPONSE_LATENCY + __builtin_ctz(family), sensor);
+  }
+
+  // Switch setters
+  void set_display_switch(DisplaySwitch *sw) { display_switch_ = sw; }
+
+  // Write command methods (for buttons/switches/numbers)
+  void send_regen_now();
+  void send_regen_next();
+  void send_sync_time();
+  void send_reset_gallons();
+  void send_reset_regens();
+  void send_set_display(bool on);
+  void send_set_hardness(uint8_t hardness);
+  void send_set_regen_time(uint8_t hour, bool is_pm);
+  void send_set_reserve_capacity(uint8_t percent);
+  void send_set_salt_level(float lbs);
+  void send_set_regen_days(uint8_t days);
+  void send_set_resin_capacity(uint16_t grains_thousands);
+  void send_set_prefill(bool enable, uint8_t duration_hours);
+  void send_set_cycle_time(uint8_t position, uint8_t minutes);
+  void send_set_low_salt_alert(uint8_t threshold);
+  void send_set_brine_tank_config(uint8_t tank_type, uint8_t fill_height);
+
+  // Getters for number controls (allow Number classes to access current values)
+  uint8_t get_brine_tank_type() const { return brine_tank_type_; }
+  uint8_t get_brine_fill_height() const { return brine_fill_height_; }
+
+  // Reset per-connection state (transport calls this on connect and disconnect)
+  void reset_session();
+  // Ask the device for its handshake ('t' x 20) to start the session
+  void send_handshake_request();
+
+  // Request data from device: all families, or any combination of RequestFamily bits
+  void request_data();
+  void request_families(uint8_t families);
+
+  // Send keepalive to maintain connection
+  void send_keepalive();
+
+ protected:
+  // Protocol parser state - ring buffer for efficiency
+  // The first MIRROR_SIZE bytes are duplicated past the end so any frame
+  // starting at the tail can be read as one contiguous span.
+  static constexpr size_t BUFFER_SIZE = 256;  // Power of 2 for fast modulo
+  static constexpr size_t MIRROR_SIZE = 32;   // >= longest frame (20 bytes)
+  uint8_t buffer_[BUFFER_SIZE + MIRROR_SIZE];
+  size_t buffer_head_{0};  // Write position
+  size_t buffer_tail_{0};  // Read position
+
+  // Connection state machine, advanced by incoming frames and loop() timers:
+  // handshake -> auth sent -> auth settling -> verifying (first data) -> ready
+  enum ConnectionState : uint8_t {
+    CONN_AWAIT_HANDSHAKE,  // Connected, waiting for the tt frame
+    CONN_AUTH_SENT,        // Auth packet queued, waiting for the write to complete
+    CONN_AUTH_SETTLING,    // Giving the device time to process the auth packet
+    CONN_VERIFYING,        // Data requested, no data frame received yet
+    CONN_READY,            // Device answered data requests
+  };
+  ConnectionState conn_state_{CONN_AWAIT_HANDSHAKE};
+  uint32_t conn_state_time_{0};  // When conn_state_ last changed
+  uint8_t auth_failures_{0};
+  bool auth_acked_{false};        // The pending auth write completed successfully
+  uint32_t auth_backoff_ms_{0};   // Length of the current lockout, 0 = none since the last session
+  uint32_t auth_retry_time_{0};   // When the lockout ends
+  void set_conn_state(ConnectionState state);
+  // Keepalives and polling run once data has been requested
+  bool session_active() const { return conn_state_ >= CONN_VERIFYING; }
+  uint32_t last_frame_time_{0};  // When the last data frame was decoded
+  // Poll cycle finished: every request answered and the device has gone quiet
+  bool session_idle(uint32_t now) const;
+  uint8_t status_packet_count_{0};
+  uint8_t connection_counter_{0};
+  uint8_t firmware_major_{0};
+  uint8_t firmware_minor_{0};
+  bool auth_required_{false};
+
+  // Outstanding data requests (RequestFamily bits queued or in flight)
+  uint8_t pending_requests_{0};
+  uint32_t request_time_{0};  // When the last request completed
+  uint8_t deferred_requests_{0};  // Read back after a write command
+  uint32_t deferred_request_time_{0};
+
+  // Brine tank configuration (from uu-1)
+  uint8_t brine_tank_type_{16};
+  uint8_t brine_fill_height_{0};
+  uint8_t brine_refill_time_{0};
+  uint8_t brine_regens_remaining_{0xFF};
+  bool brine_tank_configured_{false};
+  float last_valid_salt_level_{0.0f};
+
+  // Last valid values for sensor validation (prevent errant readings)
+  uint16_t last_valid_water_usage_today_{0};
+  uint16_t last_valid_soft_water_remaining_{0};
+  float last_valid_current_flow_{0.0f};
+  float last_valid_peak_flow_{0.0f};
+  uint32_t last_valid_total_gallons_{0};
+  float last_valid_avg_daily_usage_{0.0f};
+  bool has_valid_readings_{false};  // True after first valid data
+
+  // Current flag states
+  uint8_t current_flags_{0};
+  bool regen_active_{false};
+
+  // Daily usage history (62 days), raw device bytes in units of DAILY_USAGE_SCALE gallons
+  uint8_t daily_usage_data_[frames::DAILY_USAGE_DAYS] = {0};
+  uint8_t published_usage_data_[frames::DAILY_USAGE_DAYS] = {0};  // As last sent to usage_history
+  bool usage_history_published_{false};
+
+  // Peak flow (ww-2) and regeneration (ww-3) history, raw entries
+  uint8_t peak_flow_history_[frames::HISTORY_ENTRIES] = {0};
+  uint8_t regen_history_[frames::HISTORY_ENTRIES] = {0};
+
+  // Rolling windows over the newest days of the history. Sum, count, the
+  // value histogram and min/max are updated incrementally when the history
+  // shifts by a day; the EWMA runs over completed days (today is still
+  // accumulating).
+  struct UsageWindow {
+    uint8_t days;
+    uint16_t sum{0};    // Raw bytes over non-zero days
+    uint8_t count{0};   // Non-zero days
+    uint8_t min{0};     // Smallest and largest non-zero day, raw
+    uint8_t max{0};
+    float ewma{0.0f};   // Raw units
+    uint8_t histogram[256]{};  // Non-zero days per raw value, for the median
+  };
+  static constexpr uint8_t AVG_USAGE_WINDOW = 2;  // 31 days, as averaged by the app
+  UsageWindow usage_windows_[USAGE_WINDOW_COUNT]{{7}, {14}, {31}, {62}};
+  uint8_t usage_stats_data_[frames::DAILY_USAGE_DAYS] = {0};  // History the windows were computed from
+  bool usage_stats_valid_{false};
+
+  // Dashboard history from uu-2 and its headerless uu-3..5 continuations, as last published
+  uint8_t status_history_[frames::STATUS_HISTORY_BYTES] = {0};
+
+  // Configuration
+  uint16_t password_{DEFAULT_PASSWORD};
+  uint32_t poll_interval_ms_{60000};  // Default 60 seconds
+  uint32_t last_poll_time_{0};
+  uint32_t fast_poll_interval_ms_{10000};  // Status-only polling while water flows or regen runs
+  uint32_t last_fast_poll_time_{0};
+  uint32_t statistics_interval_ms_{300000};  // Totals and history every 5 minutes
+  uint32_t last_statistics_time_{0};
+  bool flow_active_{false};
+  uint32_t last_keepalive_time_{0};
+  uint32_t keepalive_interval_ms_{4000};  // Send keepalive every 4 seconds
+
+  // Change-only publishing
+  uint32_t heartbeat_interval_ms_{900000};  // Republish everything every 15 minutes, 0 = never
+  uint32_t last_heartbeat_time_{0};
+  float flow_deadband_{0.0f};  // GPM
+  float salt_deadband_{0.0f};  // lbs
+  bool republish_pending_{true};  // Publish unchanged values on the next poll cycle
+  bool force_publish_{false};     // Current poll cycle publishes unchanged values
+  void check_heartbeat(uint32_t now);
+
+  // Entity registries, indexed by SensorId etc.
+  EntityRegistry<sensor::Sensor, SENSOR_COUNT> sensors_;
+  EntityRegistry<text_sensor::TextSensor, TEXT_SENSOR_COUNT> text_sensors_;
+  EntityRegistry<binary_sensor::BinarySensor, BINARY_SENSOR_COUNT> binary_sensors_;
+  EntityRegistry<number::Number, NUMBER_COUNT> numbers_;
+
+  // Switches
+  DisplaySwitch *display_switch_{nullptr};
+
+  // Table-driven frame dispatch
+  static constexpr uint8_t NUMBER_ANY = 0xFF;         // Matches any packet number
+  static constexpr uint8_t MAX_FRAMES_PER_CALL = 16;  // Drain budget per notification
+
+  // Continuation sequences: a headed frame opens a record that headerless
+  // segments complete. Segment 0 describes the data taken from the headed
+  // frame; the decoder runs once on the assembled record.
+  struct SegmentSpec {
+    uint8_t offset;      // First data byte within the segment
+    uint8_t count;       // Data bytes copied into the record
+    uint8_t length;      // Segment length on the wire (continuations)
+    uint8_t end_marker;  // Expected last byte, 0 = not validated
+  };
+  static constexpr uint8_t MAX_SEQUENCE_SEGMENTS = 4;
+  struct SequenceSpec {
+    const char *name;
+    uint8_t segment_count;
+    SegmentSpec segments[MAX_SEQUENCE_SEGMENTS];
+    void (CulliganProtocol::*decoder)(const uint8_t *record);
+  };
+  static const SequenceSpec STATUS_HISTORY_SEQUENCE;
+  static const SequenceSpec DAILY_USAGE_SEQUENCE;
+
+  struct FrameSpec {
+    uint8_t header;      // Repeated header byte ('t', 'u', 'v', 'w', 'x')
+    uint8_t number;      // Packet number at offset 2, or NUMBER_ANY
+    uint8_t length;      // Total frame length in bytes
+    uint8_t end_marker;  // Expected last byte, 0 = not validated
+    const SequenceSpec *sequence;  // Opens a continuation sequence, nullptr = single frame
+    void (CulliganProtocol::*handler)(const uint8_t *frame);  // Decoder, nullptr = consume silently
+  };
+  static const FrameSpec FRAME_TABLE[];
+  static const FrameSpec *find_frame_spec(uint8_t header, uint8_t number);
+
+  // Reassembly state: one open sequence at a time
+  const SequenceSpec *sequence_{nullptr};
+  uint8_t sequence_segment_{0};  // Next segment expected
+  uint8_t sequence_length_{0};   // Record bytes filled so far
+  uint32_t sequence_time_{0};    // When the last segment arrived
+  uint8_t sequence_record_[frames::MAX_RECORD_LENGTH];
+  void open_sequence(const SequenceSpec &sequence, const uint8_t *frame);
+  bool process_continuation();
+  void close_sequence(const char *reason);
+
+  // Protocol parsing methods (decoders receive a contiguous view of one frame)
+  void process_buffer();
+  bool process_next_frame();
+  bool decode_direct(const uint8_t *data, uint16_t length);
+  void dispatch_frame(const FrameSpec &spec, const uint8_t *frame);
+  void parse_handshake(const uint8_t *frame);
+  void parse_status_realtime(const uint8_t *frame);
+  void parse_status_brine(const uint8_t *frame);
+  void parse_status_history(const uint8_t *record);
+  void parse_settings_config(const uint8_t *frame);
+  void parse_settings_cycle_times(const uint8_t *frame);
+  void parse_statistics_totals(const uint8_t *frame);
+  void parse_statistics_daily_usage(const uint8_t *record);
+  void parse_statistics_peak_flow(const uint8_t *frame);
+  void parse_statistics_regens(const uint8_t *frame);
+
+  // Warm start: last good frames and firmware version, persisted across reboots
+  // and replayed through the decoders in setup() so entities publish immediately
+  static constexpr uint8_t CACHED_FRAME_COUNT = 5;  // uu-0, uu-1, vv-0, vv-1, ww-0
+  static constexpr uint8_t STATE_CACHE_VERSION = 2;
+  struct StateCache {
+    uint8_t version;
+    uint8_t firmware_major;
+    uint8_t firmware_minor;
+    uint8_t valid_mask;  // Bit i set = frames[i] holds a frame
+    uint8_t frames[CACHED_FRAME_COUNT][frames::MAX_FRAME_LENGTH];
+  };
+  StateCache state_cache_{};
+  ESPPreferenceObject state_pref_;
+  uint32_t cache_key_{0};
+  bool state_cache_dirty_{false};
+  uint32_t last_cache_save_time_{0};
+  void restore_state_cache();
+  void cache_frame(const FrameSpec &spec, const uint8_t *frame);
+
+  // Authentication methods
+  void send_authentication();
+  std::vector<uint8_t> build_auth_packet();
+  uint8_t get_random_polynomial();
+
+  // Trace ring: records are only ever dropped whole, from the tail
+  std::vector<uint8_t> trace_;
+  size_t trace_head_{0};
+  size_t trace_tail_{0};
+  size_t trace_used_{0};
+  uint32_t trace_last_time_{0};
+  bool trace_replaying_{false};
+  void trace_record(bool write, const uint8_t *data, size_t length);
+  void trace_put(const uint8_t *data, size_t length);
+  void replay_request(uint8_t index, bool batch_start);
+
+  // Transport hook: start one command write to the device. Returns false if the
+  // transport cannot accept it; otherwise the transport must report the result
+  // through on_write_complete().
+  virtual bool write_command(const uint8_t *data, size_t length) = 0;
+  // Write a 20-byte device command and schedule a read-back of what it changed
+  void send_command(const uint8_t *cmd);
+
+  // Serialized write queue: one write in flight, next one issued on completion
+  enum WritePriority : uint8_t {
+    WRITE_PRIORITY_COMMAND,    // User commands, handshake and authentication
+    WRITE_PRIORITY_REQUEST,    // u/v/w data requests
+    WRITE_PRIORITY_KEEPALIVE,
+  };
+  static constexpr uint8_t COMMAND_LENGTH = 20;
+  static constexpr uint8_t WRITE_QUEUE_SIZE = 8;
+  struct QueuedWrite {
+    uint8_t data[COMMAND_LENGTH];
+    WritePriority priority;
+    uint8_t attempts;
+  };
+  QueuedWrite write_queue_[WRITE_QUEUE_SIZE];
+  uint8_t write_queue_count_{0};
+  bool write_in_flight_{false};
+  uint32_t write_time_{0};        // When the in-flight write was issued
+  uint32_t write_retry_time_{0};  // Earliest time for the next attempt after a failure
+  bool enqueue_write(const uint8_t *cmd, WritePriority priority);
+  void pump_writes();
+  void forget_request(const QueuedWrite &entry);
+  void clear_writes();
+
+  // Commands issued while disconnected wait for the next verified session
+  static constexpr uint8_t HELD_COMMANDS_SIZE = 4;
+  uint8_t held_commands_[HELD_COMMANDS_SIZE][COMMAND_LENGTH];
+  uint8_t held_command_count_{0};
+  void release_held_commands();
+
+  // Link usage per hour: connected time and GATT packets (writes + notifications)
+  bool link_connected_{false};
+  uint32_t link_connected_since_{0};
+  uint32_t link_window_start_{0};
+  uint32_t link_connected_ms_{0};  // Connected time in the current window, closed intervals only
+  uint32_t link_packets_{0};
+  void publish_link_usage(uint32_t now);
+
+  // Diagnostics: counters for the current hour, and start times of the
+  // latencies being measured
+  uint16_t diagnostic_counters_[DIAG_COUNTER_COUNT]{};
+  inline void count(DiagnosticCounter counter) { this->diagnostic_counters_[counter]++; }
+  uint32_t handshake_time_{0};
+  uint32_t response_wait_start_[3]{};
+  uint8_t awaiting_response_{0};  // Request families written but not answered yet
+  void measure_latencies(uint8_t header, uint32_t now);
+
+  // Ring buffer helper methods (inline for performance)
+  inline size_t buffer_size() const {
+    return (buffer_head_ >= buffer_tail_) ?
+           (buffer_head_ - buffer_tail_) :
+           (BUFFER_SIZE - buffer_tail_ + buffer_head_);
+  }
+
+  inline void buffer_clear() {
+    buffer_head_ = 0;
+    buffer_tail_ = 0;
+  }
+
+  inline uint8_t buffer_peek(size_t offset) const {
+    return buffer_[(buffer_tail_ + offset) & (BUFFER_SIZE - 1)];
+  }
+
+  // Contiguous view of the buffered data, valid for up to MIRROR_SIZE bytes
+  inline const uint8_t *buffer_data() const { return &buffer_[buffer_tail_]; }
+
+  inline void buffer_consume(size_t count) {
+    buffer_tail_ = (buffer_tail_ + count) & (BUFFER_SIZE - 1);
+  }
+
+  void buffer_append(const uint8_t *data, size_t length);
+  size_t find_header_pair(size_t from) const;
+  bool resync();
+
+  // Battery level lookup
+  float get_battery_percent(uint8_t raw);
+
+  // Brine tank salt calculation
+  float calculate_salt_remaining();
+  float get_tank_multiplier(uint8_t tank_type);
+
+  // Time formatting: "12:59 PM" into a fixed buffer, rendered only when the
+  // time bytes (packed in key) change
+  static constexpr size_t TIME_TEXT_SIZE = 12;
+  static void format_time_12h(char *buf, uint8_t hour, uint8_t minute, uint8_t am_pm);
+  void publish_time_12h(text_sensor::TextSensor *sensor, uint32_t &key, uint8_t hour, uint8_t minute, uint8_t am_pm);
+  uint32_t device_time_key_{UINT32_MAX};
+  uint32_t regen_time_key_{UINT32_MAX};
+  std::string format_time_24h(uint8_t hour, uint8_t minute);
+
+  // Flag parsing
+  void parse_flags(uint8_t flags);
+
+  // Publish only when the value differs from the entity's last state (by more
+  // than deadband for floats) or when a heartbeat/reconnect forces a refresh
+  void publish(sensor::Sensor *sensor, float value, float deadband = 0.0f);
+  void publish(text_sensor::TextSensor *sensor, const std::string &value);
+  void publish(text_sensor::TextSensor *sensor, const char *value);
+  void publish(binary_sensor::BinarySensor *sensor, bool value);
+  void publish(number::Number *number, float value);
+  void publish(switch_::Switch *sw, bool value);
+  // Publish by registry id; unconfigured ids are skipped
+  void publish(SensorId id, float value, float deadband = 0.0f) { this->publish(this->sensors_.get(id), value, deadband); }
+  void publish(TextSensorId id, const std::string &value) { this->publish(this->text_sensors_.get(id), value); }
+  void publish(TextSensorId id, const char *value) { this->publish(this->text_sensors_.get(id), value); }
+  void publish(BinarySensorId id, bool value) { this->publish(this->binary_sensors_.get(id), value); }
+  void publish(NumberId id, float value) { this->publish(this->numbers_.get(id), value); }
+
+  // Daily usage history
+  void calculate_avg_daily_usage();
+  void update_usage_windows();
+  void publish_usage_window(const UsageWindow &window);
+  void publish_usage_history();
+  static std::string format_byte_list(const uint8_t *data, size_t count);
+
+  // Sensor value validation (prevents errant readings from corrupt packets)
+  uint16_t validate_water_usage_today(uint16_t raw_value);
+  uint16_t validate_soft_water_remaining(uint16_t raw_value);
+  float validate_current_flow(float raw_value);
+  float validate_peak_flow(float raw_value);
+  uint32_t validate_total_gallons(uint32_t raw_value);
+  float validate_avg_daily_usage(float raw_value);
+};
+
+}  // namespace culligan_water_softener
+}  // namespace esphome
+
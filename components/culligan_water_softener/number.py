@@ -11,6 +11,7 @@ from esphome.const import (
 from . import (
     CulliganWaterSoftener,
     culligan_ns,
+    use_entity,
     HardnessNumber,
     RegenTimeHourNumber,
     ReserveCapacityNumber,
@@ -53,6 +54,25 @@ CONF_LOW_SALT_ALERT = "low_salt_alert"
 CONF_BRINE_TANK_TYPE = "brine_tank_type"
 CONF_BRINE_FILL_HEIGHT = "brine_fill_height"
 
+NumberId = culligan_ns.enum("NumberId")
+# Registry id and accepted range for each number key
+NUMBERS = {
+    CONF_WATER_HARDNESS: (NumberId.NUMBER_HARDNESS, 0, 99),
+    CONF_REGEN_TIME_HOUR: (NumberId.NUMBER_REGEN_TIME_HOUR, 1, 12),
+    CONF_RESERVE_CAPACITY: (NumberId.NUMBER_RESERVE_CAPACITY, 0, 49),
+    CONF_SALT_LEVEL: (NumberId.NUMBER_SALT_LEVEL, 0, 500),  # Max based on largest tank size
+    CONF_REGEN_DAYS: (NumberId.NUMBER_REGEN_DAYS, 0, 29),
+    CONF_RESIN_CAPACITY: (NumberId.NUMBER_RESIN_CAPACITY, 0, 399),  # Thousands of grains
+    CONF_PREFILL_DURATION: (NumberId.NUMBER_PREFILL_DURATION, 0, 4),  # 0 = disabled
+    CONF_BACKWASH_TIME: (NumberId.NUMBER_BACKWASH_TIME, 0, 99),
+    CONF_BRINE_DRAW_TIME: (NumberId.NUMBER_BRINE_DRAW_TIME, 0, 99),
+    CONF_RAPID_RINSE_TIME: (NumberId.NUMBER_RAPID_RINSE_TIME, 0, 99),
+    CONF_BRINE_REFILL_TIME: (NumberId.NUMBER_BRINE_REFILL_TIME, 0, 99),
+    CONF_LOW_SALT_ALERT: (NumberId.NUMBER_LOW_SALT_ALERT, 0, 100),
+    CONF_BRINE_TANK_TYPE: (NumberId.NUMBER_BRINE_TANK_TYPE, 16, 30),
+    CONF_BRINE_FILL_HEIGHT: (NumberId.NUMBER_BRINE_FILL_HEIGHT, 1, 48),
+}
+
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_CULLIGAN_WATER_SOFTENER_ID): cv.use_id(CulliganWaterSoftener),
@@ -133,156 +153,15 @@ async def to_code(config):
     """Generate number code."""
     parent = await cg.get_variable(config[CONF_CULLIGAN_WATER_SOFTENER_ID])
 
-    if CONF_WATER_HARDNESS in config:
-        num = await number.new_number(
-            config[CONF_WATER_HARDNESS],
-            min_value=0,
-            max_value=99,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_hardness_number(num))
-
-    if CONF_REGEN_TIME_HOUR in config:
-        num = await number.new_number(
-            config[CONF_REGEN_TIME_HOUR],
-            min_value=1,
-            max_value=12,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_regen_time_hour_number(num))
-
-    if CONF_RESERVE_CAPACITY in config:
-        num = await number.new_number(
-            config[CONF_RESERVE_CAPACITY],
-            min_value=0,
-            max_value=49,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_reserve_capacity_number(num))
-
-    if CONF_SALT_LEVEL in config:
-        num = await number.new_number(
-            config[CONF_SALT_LEVEL],
-            min_value=0,
-            max_value=500,  # Max based on largest tank size
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_salt_level_number(num))
-
-    if CONF_REGEN_DAYS in config:
-        num = await number.new_number(
-            config[CONF_REGEN_DAYS],
-            min_value=0,
-            max_value=29,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_regen_days_number(num))
-
-    if CONF_RESIN_CAPACITY in config:
-        num = await number.new_number(
-            config[CONF_RESIN_CAPACITY],
-            min_value=0,
-            max_value=399,  # Thousands of grains (0-399 = 0-399,000)
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_resin_capacity_number(num))
-
-    if CONF_PREFILL_DURATION in config:
-        num = await number.new_number(
-            config[CONF_PREFILL_DURATION],
-            min_value=0,  # 0 = disabled
-            max_value=4,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_prefill_duration_number(num))
-
-    if CONF_BACKWASH_TIME in config:
-        num = await number.new_number(
-            config[CONF_BACKWASH_TIME],
-            min_value=0,
-            max_value=99,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_backwash_time_number(num))
-
-    if CONF_BRINE_DRAW_TIME in config:
-        num = await number.new_number(
-            config[CONF_BRINE_DRAW_TIME],
-            min_value=0,
-            max_value=99,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_brine_draw_time_number(num))
-
-    if CONF_RAPID_RINSE_TIME in config:
-        num = await number.new_number(
-            config[CONF_RAPID_RINSE_TIME],
-            min_value=0,
-            max_value=99,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_rapid_rinse_time_number(num))
-
-    if CONF_BRINE_REFILL_TIME in config:
-        num = await number.new_number(
-            config[CONF_BRINE_REFILL_TIME],
-            min_value=0,
-            max_value=99,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_brine_refill_time_number(num))
-
-    if CONF_LOW_SALT_ALERT in config:
-        num = await number.new_number(
-            config[CONF_LOW_SALT_ALERT],
-            min_value=0,
-            max_value=100,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_low_salt_alert_number(num))
-
-    if CONF_BRINE_TANK_TYPE in config:
-        num = await number.new_number(
-            config[CONF_BRINE_TANK_TYPE],
-            min_value=16,
-            max_value=30,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_brine_tank_type_number(num))
-
-    if CONF_BRINE_FILL_HEIGHT in config:
-        num = await number.new_number(
-            config[CONF_BRINE_FILL_HEIGHT],
-            min_value=1,
-            max_value=48,
-            step=1,
-        )
-        cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
-        await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
-        cg.add(parent.set_brine_fill_height_number(num))
+    for key, (entity_id, min_value, max_value) in NUMBERS.items():
+        if key in config:
+            num = await number.new_number(
+                config[key],
+                min_value=min_value,
+                max_value=max_value,
+                step=1,
+            )
+            cg.add(num.traits.set_mode(NumberMode.NUMBER_MODE_BOX))
+            await cg.register_parented(num, config[CONF_CULLIGAN_WATER_SOFTENER_ID])
+            cg.add(parent.set_number(entity_id, num))
+            use_entity(entity_id)
@@ -5,6 +5,9 @@ from esphome.components import sensor
 from esphome.const import (
     CONF_ID,
     UNIT_PERCENT,
+    UNIT_SECOND,
+    UNIT_MILLISECOND,
+    ENTITY_CATEGORY_DIAGNOSTIC,
     DEVICE_CLASS_BATTERY,
     DEVICE_CLASS_WATER,
     STATE_CLASS_MEASUREMENT,
@@ -13,6 +16,7 @@ from esphome.const import (
 from . import (
     CulliganWaterSoftener,
     culligan_ns,
+    use_entity,
     UNIT_GPM,
     UNIT_GPG,
     UNIT_LBS,
@@ -46,6 +50,10 @@ CONF_TOTAL_GALLONS = "total_gallons"
 CONF_TOTAL_REGENS = "total_regenerations"
 CONF_BATTERY_LEVEL = "battery_level"
 
+# Link usage, reported once per hour
+CONF_CONNECTED_TIME = "connected_time"
+CONF_LINK_PACKETS = "link_packets"
+
 # New sensors for Phase 3
 CONF_RESERVE_CAPACITY = "reserve_capacity"
 CONF_RESIN_CAPACITY = "resin_capacity"
@@ -73,6 +81,116 @@ CONF_CYCLE_POSITION_8 = "cycle_position_8"
 CONF_BRINE_TANK_TYPE = "brine_tank_type"
 CONF_BRINE_FILL_HEIGHT = "brine_fill_height"
 
+# Rolling usage statistics: one block per window of the 62-day history
+UsageStat = culligan_ns.enum("UsageStat")
+USAGE_WINDOWS = {
+    "usage_7d": 7,
+    "usage_14d": 14,
+    "usage_31d": 31,
+    "usage_62d": 62,
+}
+USAGE_STATS = {
+    "average": UsageStat.USAGE_STAT_AVERAGE,
+    "minimum": UsageStat.USAGE_STAT_MINIMUM,
+    "maximum": UsageStat.USAGE_STAT_MAXIMUM,
+    "median": UsageStat.USAGE_STAT_MEDIAN,
+    "ewma": UsageStat.USAGE_STAT_EWMA,
+}
+USAGE_WINDOW_SCHEMA = cv.Schema(
+    {
+        cv.Optional(stat): sensor.sensor_schema(
+            unit_of_measurement=UNIT_GALLON,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_WATER,
+            state_class=STATE_CLASS_MEASUREMENT,
+            icon=ICON_WATER,
+        )
+        for stat in USAGE_STATS
+    }
+)
+
+# Protocol health: counters published once per hour, latencies as measured
+DiagnosticCounter = culligan_ns.enum("DiagnosticCounter")
+RequestFamily = culligan_ns.enum("RequestFamily")
+DIAGNOSTIC_COUNTERS = {
+    "frames_handshake": DiagnosticCounter.DIAG_FRAMES_HANDSHAKE,
+    "frames_status": DiagnosticCounter.DIAG_FRAMES_STATUS,
+    "frames_settings": DiagnosticCounter.DIAG_FRAMES_SETTINGS,
+    "frames_statistics": DiagnosticCounter.DIAG_FRAMES_STATISTICS,
+    "frames_keepalive": DiagnosticCounter.DIAG_FRAMES_KEEPALIVE,
+    "marker_rejects": DiagnosticCounter.DIAG_MARKER_REJECTS,
+    "resyncs": DiagnosticCounter.DIAG_RESYNCS,
+    "buffer_overflows": DiagnosticCounter.DIAG_BUFFER_OVERFLOWS,
+    "write_failures": DiagnosticCounter.DIAG_WRITE_FAILURES,
+    "rejects_water_usage_today": DiagnosticCounter.DIAG_REJECTS_WATER_USAGE_TODAY,
+    "rejects_soft_water_remaining": DiagnosticCounter.DIAG_REJECTS_SOFT_WATER_REMAINING,
+    "rejects_current_flow": DiagnosticCounter.DIAG_REJECTS_CURRENT_FLOW,
+    "rejects_peak_flow": DiagnosticCounter.DIAG_REJECTS_PEAK_FLOW,
+    "rejects_total_gallons": DiagnosticCounter.DIAG_REJECTS_TOTAL_GALLONS,
+    "rejects_avg_daily_usage": DiagnosticCounter.DIAG_REJECTS_AVG_DAILY_USAGE,
+}
+CONF_HANDSHAKE_LATENCY = "handshake_latency"
+RESPONSE_LATENCIES = {
+    "response_latency_status": RequestFamily.REQUEST_STATUS,
+    "response_latency_settings": RequestFamily.REQUEST_SETTINGS,
+    "response_latency_statistics": RequestFamily.REQUEST_STATISTICS,
+}
+DIAGNOSTIC_COUNTER_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    icon="mdi:counter",
+)
+LATENCY_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    icon="mdi:timer-sand",
+)
+
+SensorId = culligan_ns.enum("SensorId")
+# Registry id each plain sensor key is registered under
+SENSORS = {
+    CONF_CURRENT_FLOW: SensorId.SENSOR_CURRENT_FLOW,
+    CONF_SOFT_WATER_REMAINING: SensorId.SENSOR_SOFT_WATER_REMAINING,
+    CONF_WATER_USAGE_TODAY: SensorId.SENSOR_WATER_USAGE_TODAY,
+    CONF_PEAK_FLOW_TODAY: SensorId.SENSOR_PEAK_FLOW_TODAY,
+    CONF_WATER_HARDNESS: SensorId.SENSOR_WATER_HARDNESS,
+    CONF_BRINE_LEVEL: SensorId.SENSOR_BRINE_LEVEL,
+    CONF_AVG_DAILY_USAGE: SensorId.SENSOR_AVG_DAILY_USAGE,
+    CONF_DAYS_UNTIL_REGEN: SensorId.SENSOR_DAYS_UNTIL_REGEN,
+    CONF_TOTAL_GALLONS: SensorId.SENSOR_TOTAL_GALLONS,
+    CONF_TOTAL_REGENS: SensorId.SENSOR_TOTAL_REGENS,
+    CONF_BATTERY_LEVEL: SensorId.SENSOR_BATTERY_LEVEL,
+    CONF_CONNECTED_TIME: SensorId.SENSOR_CONNECTED_TIME,
+    CONF_LINK_PACKETS: SensorId.SENSOR_LINK_PACKETS,
+    CONF_HANDSHAKE_LATENCY: SensorId.SENSOR_HANDSHAKE_LATENCY,
+    CONF_RESERVE_CAPACITY: SensorId.SENSOR_RESERVE_CAPACITY,
+    CONF_RESIN_CAPACITY: SensorId.SENSOR_RESIN_CAPACITY,
+    CONF_PREFILL_DURATION: SensorId.SENSOR_PREFILL_DURATION,
+    CONF_SOAK_DURATION: SensorId.SENSOR_SOAK_DURATION,
+    CONF_BACKWASH_TIME: SensorId.SENSOR_BACKWASH_TIME,
+    CONF_BRINE_DRAW_TIME: SensorId.SENSOR_BRINE_DRAW_TIME,
+    CONF_RAPID_RINSE_TIME: SensorId.SENSOR_RAPID_RINSE_TIME,
+    CONF_BRINE_REFILL_TIME: SensorId.SENSOR_BRINE_REFILL_TIME,
+    CONF_FILTER_BACKWASH_DAYS: SensorId.SENSOR_FILTER_BACKWASH_DAYS,
+    CONF_AIR_RECHARGE_DAYS: SensorId.SENSOR_AIR_RECHARGE_DAYS,
+    CONF_LOW_SALT_ALERT: SensorId.SENSOR_LOW_SALT_ALERT,
+    CONF_BRINE_TANK_CAPACITY: SensorId.SENSOR_BRINE_TANK_CAPACITY,
+    CONF_BRINE_SALT_PERCENT: SensorId.SENSOR_BRINE_SALT_PERCENT,
+    CONF_REGEN_DAY_OVERRIDE: SensorId.SENSOR_REGEN_DAY_OVERRIDE,
+    CONF_AIR_RECHARGE_FREQUENCY: SensorId.SENSOR_AIR_RECHARGE_FREQUENCY,
+    CONF_TOTAL_GALLONS_RESETTABLE: SensorId.SENSOR_TOTAL_GALLONS_RESETTABLE,
+    CONF_TOTAL_REGENS_RESETTABLE: SensorId.SENSOR_TOTAL_REGENS_RESETTABLE,
+    CONF_CYCLE_POSITION_5: SensorId.SENSOR_CYCLE_POSITION_5,
+    CONF_CYCLE_POSITION_6: SensorId.SENSOR_CYCLE_POSITION_6,
+    CONF_CYCLE_POSITION_7: SensorId.SENSOR_CYCLE_POSITION_7,
+    CONF_CYCLE_POSITION_8: SensorId.SENSOR_CYCLE_POSITION_8,
+    CONF_BRINE_TANK_TYPE: SensorId.SENSOR_BRINE_TANK_TYPE,
+    CONF_BRINE_FILL_HEIGHT: SensorId.SENSOR_BRINE_FILL_HEIGHT,
+}
+
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_CULLIGAN_WATER_SOFTENER_ID): cv.use_id(CulliganWaterSoftener),
@@ -122,6 +240,7 @@ CONFIG_SCHEMA = cv.Schema(
             state_class=STATE_CLASS_MEASUREMENT,
             icon=ICON_WATER,
         ),
+        **{cv.Optional(window): USAGE_WINDOW_SCHEMA for window in USAGE_WINDOWS},
         cv.Optional(CONF_DAYS_UNTIL_REGEN): sensor.sensor_schema(
             unit_of_measurement="days",
             accuracy_decimals=0,
@@ -146,6 +265,20 @@ CONFIG_SCHEMA = cv.Schema(
             device_class=DEVICE_CLASS_BATTERY,
             state_class=STATE_CLASS_MEASUREMENT,
         ),
+        cv.Optional(CONF_CONNECTED_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            icon="mdi:bluetooth-connect",
+        ),
+        cv.Optional(CONF_LINK_PACKETS): sensor.sensor_schema(
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            icon="mdi:bluetooth-transfer",
+        ),
+        **{cv.Optional(key): DIAGNOSTIC_COUNTER_SCHEMA for key in DIAGNOSTIC_COUNTERS},
+        cv.Optional(CONF_HANDSHAKE_LATENCY): LATENCY_SCHEMA,
+        **{cv.Optional(key): LATENCY_SCHEMA for key in RESPONSE_LATENCIES},
         # New sensors for Phase 3
         cv.Optional(CONF_RESERVE_CAPACITY): sensor.sensor_schema(
             unit_of_measurement=UNIT_PERCENT,
@@ -293,140 +426,27 @@ async def to_code(config):
     """Generate sensor code."""
     parent = await cg.get_variable(config[CONF_CULLIGAN_WATER_SOFTENER_ID])
 
-    if CONF_CURRENT_FLOW in config:
-        sens = await sensor.new_sensor(config[CONF_CURRENT_FLOW])
-        cg.add(parent.set_current_flow_sensor(sens))
-
-    if CONF_SOFT_WATER_REMAINING in config:
-        sens = await sensor.new_sensor(config[CONF_SOFT_WATER_REMAINING])
-        cg.add(parent.set_soft_water_remaining_sensor(sens))
-
-    if CONF_WATER_USAGE_TODAY in config:
-        sens = await sensor.new_sensor(config[CONF_WATER_USAGE_TODAY])
-        cg.add(parent.set_water_usage_today_sensor(sens))
-
-    if CONF_PEAK_FLOW_TODAY in config:
-        sens = await sensor.new_sensor(config[CONF_PEAK_FLOW_TODAY])
-        cg.add(parent.set_peak_flow_today_sensor(sens))
-
-    if CONF_WATER_HARDNESS in config:
-        sens = await sensor.new_sensor(config[CONF_WATER_HARDNESS])
-        cg.add(parent.set_water_hardness_sensor(sens))
-
-    if CONF_BRINE_LEVEL in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_LEVEL])
-        cg.add(parent.set_brine_level_sensor(sens))
-
-    if CONF_AVG_DAILY_USAGE in config:
-        sens = await sensor.new_sensor(config[CONF_AVG_DAILY_USAGE])
-        cg.add(parent.set_avg_daily_usage_sensor(sens))
-
-    if CONF_DAYS_UNTIL_REGEN in config:
-        sens = await sensor.new_sensor(config[CONF_DAYS_UNTIL_REGEN])
-        cg.add(parent.set_days_until_regen_sensor(sens))
-
-    if CONF_TOTAL_GALLONS in config:
-        sens = await sensor.new_sensor(config[CONF_TOTAL_GALLONS])
-        cg.add(parent.set_total_gallons_sensor(sens))
-
-    if CONF_TOTAL_REGENS in config:
-        sens = await sensor.new_sensor(config[CONF_TOTAL_REGENS])
-        cg.add(parent.set_total_regens_sensor(sens))
-
-    if CONF_BATTERY_LEVEL in config:
-        sens = await sensor.new_sensor(config[CONF_BATTERY_LEVEL])
-        cg.add(parent.set_battery_level_sensor(sens))
-
-    # New sensors for Phase 3
-    if CONF_RESERVE_CAPACITY in config:
-        sens = await sensor.new_sensor(config[CONF_RESERVE_CAPACITY])
-        cg.add(parent.set_reserve_capacity_sensor(sens))
-
-    if CONF_RESIN_CAPACITY in config:
-        sens = await sensor.new_sensor(config[CONF_RESIN_CAPACITY])
-        cg.add(parent.set_resin_capacity_sensor(sens))
-
-    if CONF_PREFILL_DURATION in config:
-        sens = await sensor.new_sensor(config[CONF_PREFILL_DURATION])
-        cg.add(parent.set_prefill_duration_sensor(sens))
-
-    if CONF_SOAK_DURATION in config:
-        sens = await sensor.new_sensor(config[CONF_SOAK_DURATION])
-        cg.add(parent.set_soak_duration_sensor(sens))
-
-    if CONF_BACKWASH_TIME in config:
-        sens = await sensor.new_sensor(config[CONF_BACKWASH_TIME])
-        cg.add(parent.set_backwash_time_sensor(sens))
-
-    if CONF_BRINE_DRAW_TIME in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_DRAW_TIME])
-        cg.add(parent.set_brine_draw_time_sensor(sens))
-
-    if CONF_RAPID_RINSE_TIME in config:
-        sens = await sensor.new_sensor(config[CONF_RAPID_RINSE_TIME])
-        cg.add(parent.set_rapid_rinse_time_sensor(sens))
-
-    if CONF_BRINE_REFILL_TIME in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_REFILL_TIME])
-        cg.add(parent.set_brine_refill_time_sensor(sens))
-
-    # Additional sensors from Python script
-    if CONF_FILTER_BACKWASH_DAYS in config:
-        sens = await sensor.new_sensor(config[CONF_FILTER_BACKWASH_DAYS])
-        cg.add(parent.set_filter_backwash_days_sensor(sens))
-
-    if CONF_AIR_RECHARGE_DAYS in config:
-        sens = await sensor.new_sensor(config[CONF_AIR_RECHARGE_DAYS])
-        cg.add(parent.set_air_recharge_days_sensor(sens))
-
-    if CONF_LOW_SALT_ALERT in config:
-        sens = await sensor.new_sensor(config[CONF_LOW_SALT_ALERT])
-        cg.add(parent.set_low_salt_alert_sensor(sens))
-
-    if CONF_BRINE_TANK_CAPACITY in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_TANK_CAPACITY])
-        cg.add(parent.set_brine_tank_capacity_sensor(sens))
-
-    if CONF_BRINE_SALT_PERCENT in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_SALT_PERCENT])
-        cg.add(parent.set_brine_salt_percent_sensor(sens))
-
-    if CONF_REGEN_DAY_OVERRIDE in config:
-        sens = await sensor.new_sensor(config[CONF_REGEN_DAY_OVERRIDE])
-        cg.add(parent.set_regen_day_override_sensor(sens))
-
-    if CONF_AIR_RECHARGE_FREQUENCY in config:
-        sens = await sensor.new_sensor(config[CONF_AIR_RECHARGE_FREQUENCY])
-        cg.add(parent.set_air_recharge_frequency_sensor(sens))
-
-    if CONF_TOTAL_GALLONS_RESETTABLE in config:
-        sens = await sensor.new_sensor(config[CONF_TOTAL_GALLONS_RESETTABLE])
-        cg.add(parent.set_total_gallons_resettable_sensor(sens))
-
-    if CONF_TOTAL_REGENS_RESETTABLE in config:
-        sens = await sensor.new_sensor(config[CONF_TOTAL_REGENS_RESETTABLE])
-        cg.add(parent.set_total_regens_resettable_sensor(sens))
-
-    if CONF_CYCLE_POSITION_5 in config:
-        sens = await sensor.new_sensor(config[CONF_CYCLE_POSITION_5])
-        cg.add(parent.set_cycle_position_5_sensor(sens))
-
-    if CONF_CYCLE_POSITION_6 in config:
-        sens = await sensor.new_sensor(config[CONF_CYCLE_POSITION_6])
-        cg.add(parent.set_cycle_position_6_sensor(sens))
-
-    if CONF_CYCLE_POSITION_7 in config:
-        sens = await sensor.new_sensor(config[CONF_CYCLE_POSITION_7])
-        cg.add(parent.set_cycle_position_7_sensor(sens))
-
-    if CONF_CYCLE_POSITION_8 in config:
-        sens = await sensor.new_sensor(config[CONF_CYCLE_POSITION_8])
-        cg.add(parent.set_cycle_position_8_sensor(sens))
-
-    if CONF_BRINE_TANK_TYPE in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_TANK_TYPE])
-        cg.add(parent.set_brine_tank_type_sensor(sens))
-
-    if CONF_BRINE_FILL_HEIGHT in config:
-        sens = await sensor.new_sensor(config[CONF_BRINE_FILL_HEIGHT])
-        cg.add(parent.set_brine_fill_height_sensor(sens))
+    for key, entity_id in SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(parent.set_sensor(entity_id, sens))
+            use_entity(entity_id)
+
+    for window, days in USAGE_WINDOWS.items():
+        for stat, stat_enum in USAGE_STATS.items():
+            if stat in config.get(window, {}):
+                sens = await sensor.new_sensor(config[window][stat])
+                cg.add(parent.set_usage_stat_sensor(days, stat_enum, sens))
+                use_entity(SensorId.SENSOR_USAGE_STAT)
+
+    for key, counter in DIAGNOSTIC_COUNTERS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(parent.set_diagnostic_counter_sensor(counter, sens))
+            use_entity(SensorId.SENSOR_DIAGNOSTIC)
+
+    for key, family in RESPONSE_LATENCIES.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(parent.set_response_latency_sensor(family, sens))
+            use_entity(SensorId.SENSOR_RESPONSE_LATENCY)
@@ -3,7 +3,7 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import text_sensor
 from esphome.const import CONF_ID
-from . import CulliganWaterSoftener, culligan_ns
+from . import CulliganWaterSoftener, culligan_ns, use_entity
 
 DEPENDENCIES = ["culligan_water_softener"]
 
@@ -15,6 +15,23 @@ CONF_FIRMWARE_VERSION = "firmware_version"
 CONF_DEVICE_TIME = "device_time"
 CONF_REGEN_TIME = "regeneration_time"
 CONF_MAC_ADDRESS = "mac_address"
+CONF_USAGE_HISTORY = "usage_history"
+CONF_PEAK_FLOW_HISTORY = "peak_flow_history"
+CONF_REGEN_HISTORY = "regeneration_history"
+CONF_STATUS_HISTORY = "status_history"
+
+TextSensorId = culligan_ns.enum("TextSensorId")
+# Registry id each text sensor key is registered under
+TEXT_SENSORS = {
+    CONF_FIRMWARE_VERSION: TextSensorId.TEXT_SENSOR_FIRMWARE_VERSION,
+    CONF_DEVICE_TIME: TextSensorId.TEXT_SENSOR_DEVICE_TIME,
+    CONF_REGEN_TIME: TextSensorId.TEXT_SENSOR_REGEN_TIME,
+    CONF_MAC_ADDRESS: TextSensorId.TEXT_SENSOR_MAC_ADDRESS,
+    CONF_USAGE_HISTORY: TextSensorId.TEXT_SENSOR_USAGE_HISTORY,
+    CONF_PEAK_FLOW_HISTORY: TextSensorId.TEXT_SENSOR_PEAK_FLOW_HISTORY,
+    CONF_REGEN_HISTORY: TextSensorId.TEXT_SENSOR_REGEN_HISTORY,
+    CONF_STATUS_HISTORY: TextSensorId.TEXT_SENSOR_STATUS_HISTORY,
+}
 
 CONFIG_SCHEMA = cv.Schema(
     {
@@ -31,6 +48,18 @@ CONFIG_SCHEMA = cv.Schema(
         cv.Optional(CONF_MAC_ADDRESS): text_sensor.text_sensor_schema(
             icon="mdi:bluetooth",
         ),
+        cv.Optional(CONF_USAGE_HISTORY): text_sensor.text_sensor_schema(
+            icon="mdi:chart-bar",
+        ),
+        cv.Optional(CONF_PEAK_FLOW_HISTORY): text_sensor.text_sensor_schema(
+            icon="mdi:chart-line",
+        ),
+        cv.Optional(CONF_REGEN_HISTORY): text_sensor.text_sensor_schema(
+            icon="mdi:refresh",
+        ),
+        cv.Optional(CONF_STATUS_HISTORY): text_sensor.text_sensor_schema(
+            icon="mdi:history",
+        ),
     }
 )
 
@@ -39,18 +68,8 @@ async def to_code(config):
     """Generate text sensor code."""
     parent = await cg.get_variable(config[CONF_CULLIGAN_WATER_SOFTENER_ID])
 
-    if CONF_FIRMWARE_VERSION in config:
-        sens = await text_sensor.new_text_sensor(config[CONF_FIRMWARE_VERSION])
-        cg.add(parent.set_firmware_version_sensor(sens))
-
-    if CONF_DEVICE_TIME in config:
-        sens = await text_sensor.new_text_sensor(config[CONF_DEVICE_TIME])
-        cg.add(parent.set_device_time_sensor(sens))
-
-    if CONF_REGEN_TIME in config:
-        sens = await text_sensor.new_text_sensor(config[CONF_REGEN_TIME])
-        cg.add(parent.set_regen_time_sensor(sens))
-
-    if CONF_MAC_ADDRESS in config:
-        sens = await text_sensor.new_text_sensor(config[CONF_MAC_ADDRESS])
-        cg.add(parent.set_mac_address_sensor(sens))
+    for key, entity_id in TEXT_SENSORS.items():
+        if key in config:
+            sens = await text_sensor.new_text_sensor(config[key])
+            cg.add(parent.set_text_sensor(entity_id, sens))
+            use_entity(entity_id)
@@ -0,0 +1,138 @@
+/**
+ * Advertisement filter benchmark for auto-discovery
+ *
+ * Feeds parse_device() synthetic scan streams that never contain the
+ * softener, as at a busy site before it is in range, and reports the cost
+ * per advertisement. Streams:
+ *   few       12 advertisers, all fit in the rejected-address cache
+ *   many      300 advertisers, named and nameless: the cache thrashes and
+ *             most advertisements reach the name check
+ *   lookalike 300 advertisers named like the softener ("CS_Meter_Hard",
+ *             "CS_Meter_Sof1", ...): same length, worst case for the name check
+ *   private   300 advertisers on rotating private addresses, as phones use:
+ *             dropped on the address type without a name check or cache entry
+ * A matching advertisement ends each run and must be picked up. A last check
+ * sees the softener nameless, then with a shortened name, then complete, and
+ * an advertiser whose address was cached is taken once its entry expires.
+ *
+ *   advert_bench [advertisements per stream]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+#include "host_runtime.h"
+#include "sim_radio.h"
+
+using namespace esphome;
+using namespace esphome::host;
+using esp32_ble_tracker::ESPBTDevice;
+
+namespace {
+
+const char *const OTHER_NAMES[] = {"", "", "", "LE-Bose QC35", "Tile", "[TV] Samsung", "Govee_H5075_1A2B",
+                                   "MX Master 3", "ELK-BLEDOM", "", "iPhone", "Mi Smart Band 6"};
+const char *const LOOKALIKE_NAMES[] = {"CS_Meter_Hard", "CS_Meter_Sof1", "CS_Meter_Sofx", "CX_Meter_Soft",
+                                       "DS_Meter_Soft", "CS_Meter_Sift"};
+
+std::vector<ESPBTDevice> make_advertisers(size_t count, const char *const *names, size_t name_count,
+                                          bool rotating = false) {
+  std::vector<ESPBTDevice> advertisers;
+  for (size_t i = 0; i < count; i++) {
+    if (rotating) {
+      // Resolvable private address: random type, top address bits 01
+      advertisers.emplace_back(0x4A1C38000000ULL + i * 0x101, names[i % name_count], -60, BLE_ADDR_TYPE_RANDOM);
+    } else {
+      advertisers.emplace_back(0xA4C138000000ULL + i * 0x101, names[i % name_count]);
+    }
+  }
+  return advertisers;
+}
+
+// Advertisers take turns in a random order, as a scan reports them
+std::vector<const ESPBTDevice *> make_stream(const std::vector<ESPBTDevice> &advertisers, size_t length) {
+  std::vector<const ESPBTDevice *> stream;
+  stream.reserve(length);
+  for (size_t i = 0; i < length; i++) {
+    stream.push_back(&advertisers[random_uint32() % advertisers.size()]);
+  }
+  return stream;
+}
+
+bool run(const char *label, const std::vector<ESPBTDevice> &advertisers, size_t length) {
+  host_preference_store().clear();
+  ble_client::BLEClient client;
+  SimSoftener softener;
+  softener.set_ble_client_parent(&client);
+  softener.setup();
+
+  std::vector<const ESPBTDevice *> stream = make_stream(advertisers, length);
+  size_t matches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const ESPBTDevice *device : stream) {
+    matches += softener.parse_device(*device);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  ESPBTDevice softener_device(0xC0FFEE000001ULL, "CS_Meter_Soft");
+  if (matches != 0 || !softener.parse_device(softener_device) || client.get_address() != 0xC0FFEE000001ULL) {
+    fprintf(stderr, "%s: discovery check failed\n", label);
+    return false;
+  }
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-10s %4zu advertisers  %7.1f ns/advertisement\n", label, advertisers.size(), ns / length);
+  return true;
+}
+
+// The softener's first advertisements may lack the name or carry a shortened
+// one; neither may keep it from being found. A complete non-matching name is
+// cached, but only until the entry expires.
+bool check_discovery() {
+  host_preference_store().clear();
+  ble_client::BLEClient client;
+  SimSoftener softener;
+  softener.set_ble_client_parent(&client);
+  softener.setup();
+
+  bool ok = !softener.parse_device(ESPBTDevice(0xC0FFEE000001ULL, ""));
+  ok = !softener.parse_device(ESPBTDevice(0xC0FFEE000001ULL, "CS_Meter")) && ok;
+  ok = softener.parse_device(ESPBTDevice(0xC0FFEE000001ULL, "CS_Meter_Soft")) && ok;
+  ok = client.get_address() == 0xC0FFEE000001ULL && ok;
+
+  ble_client::BLEClient renamed_client;
+  SimSoftener renamed;
+  renamed.set_ble_client_parent(&renamed_client);
+  renamed.setup();
+  ok = !renamed.parse_device(ESPBTDevice(0xC0FFEE000002ULL, "Tile")) && ok;
+  ok = !renamed.parse_device(ESPBTDevice(0xC0FFEE000002ULL, "CS_Meter_Soft")) && ok;
+  advance_millis(60000);
+  ok = renamed.parse_device(ESPBTDevice(0xC0FFEE000002ULL, "CS_Meter_Soft")) && ok;
+  ok = renamed_client.get_address() == 0xC0FFEE000002ULL && ok;
+  if (!ok) {
+    fprintf(stderr, "discovery: shortened name or cache expiry check failed\n");
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t length = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  if (length == 0) {
+    fprintf(stderr, "usage: %s [advertisements per stream >= 1]\n", argv[0]);
+    return 2;
+  }
+  size_t other_count = sizeof(OTHER_NAMES) / sizeof(OTHER_NAMES[0]);
+  size_t lookalike_count = sizeof(LOOKALIKE_NAMES) / sizeof(LOOKALIKE_NAMES[0]);
+  bool ok = run("few", make_advertisers(12, OTHER_NAMES, other_count), length);
+  ok = run("many", make_advertisers(300, OTHER_NAMES, other_count), length) && ok;
+  ok = run("lookalike", make_advertisers(300, LOOKALIKE_NAMES, lookalike_count), length) && ok;
+  ok = run("private", make_advertisers(300, OTHER_NAMES, other_count, true), length) && ok;
+  ok = check_discovery() && ok;
+  return ok ? 0 : 1;
+}
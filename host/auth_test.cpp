@@ -0,0 +1,191 @@
+/**
+ * Authentication failure handling on a simulated clock
+ *
+ * A softener with firmware 5 (authentication required) answers the
+ * handshake; whether it then answers data requests decides whether the
+ * password was "accepted". Covers auth writes dropped on the link (not a
+ * rejection), the lockout after MAX_AUTH_ATTEMPTS rejections, its timed
+ * back-off and the reset after a successful session.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "fake_softener.h"
+#include "host_protocol.h"
+#include "host_runtime.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+const uint32_t AUTH_VERIFY_TIMEOUT_MS = 5000;
+const uint32_t AUTH_BACKOFF_MS = 60000;
+
+class AuthProtocol : public HostProtocol {
+ public:
+  uint8_t auth_failures() const { return this->auth_failures_; }
+  uint32_t auth_backoff_ms() const { return this->auth_backoff_ms_; }
+  bool ready() const { return this->conn_state_ == CONN_READY; }
+  bool awaiting_handshake() const { return this->conn_state_ == CONN_AWAIT_HANDSHAKE; }
+  bool warning() const { return this->status_has_warning(); }
+};
+
+bool is_auth_packet(const std::vector<uint8_t> &write) {
+  return write.size() == 20 && write[0] == 0x74 && write[2] != 0x74;
+}
+
+bool is_handshake_request(const std::vector<uint8_t> &write) {
+  return write.size() == 20 && write[0] == 0x74 && write[2] == 0x74;
+}
+
+size_t count_writes(const AuthProtocol &protocol, bool (*match)(const std::vector<uint8_t> &)) {
+  size_t count = 0;
+  for (auto &write : protocol.writes) {
+    count += match(write);
+  }
+  return count;
+}
+
+void run(AuthProtocol &protocol, uint32_t duration_ms) {
+  for (uint32_t elapsed = 0; elapsed < duration_ms; elapsed += 10) {
+    advance_millis(10);
+    protocol.loop();
+  }
+}
+
+void deliver(AuthProtocol &protocol, const std::vector<Notification> &notifications) {
+  for (auto &notification : notifications) {
+    protocol.handle_notification(notification.data(), notification.size());
+  }
+}
+
+// Device handshake arrives and the auth write goes out and is acknowledged
+void authenticate(AuthProtocol &protocol, const FakeSoftener &device) {
+  uint8_t request[20];
+  std::fill_n(request, sizeof(request), 0x74);
+  deliver(protocol, device.respond(request, sizeof(request)));
+  protocol.complete_writes();
+}
+
+// Acknowledged auth, then no data: one rejection
+void rejected_attempt(AuthProtocol &protocol, const FakeSoftener &device) {
+  authenticate(protocol, device);
+  run(protocol, 300);  // Settle, then data is requested
+  protocol.complete_writes();
+  run(protocol, AUTH_VERIFY_TIMEOUT_MS);
+  protocol.complete_writes();
+}
+
+void start(AuthProtocol &protocol) {
+  set_millis(1000);
+  protocol.setup();
+  protocol.set_link_connected(true);
+  protocol.send_handshake_request();
+  protocol.complete_writes();
+  protocol.writes.clear();
+}
+
+void test_dropped_auth_write() {
+  AuthProtocol protocol;
+  FakeSoftener device;
+  device.firmware_major = 5;
+  start(protocol);
+
+  uint8_t request[20];
+  std::fill_n(request, sizeof(request), 0x74);
+  deliver(protocol, device.respond(request, sizeof(request)));
+  CHECK(count_writes(protocol, is_auth_packet) == 1);
+  // All three attempts fail, so the queue gives up on the write
+  for (int i = 0; i < 3; i++) {
+    CHECK(protocol.write_in_flight() && is_auth_packet(protocol.writes.back()));
+    protocol.fail_write();
+    run(protocol, 100);
+  }
+  CHECK(protocol.auth_failures() == 0);
+  CHECK(!protocol.warning());
+  CHECK(protocol.awaiting_handshake());
+  CHECK(count_writes(protocol, is_handshake_request) == 1);  // Handshake restarted
+
+  // The retry gets through and the device answers
+  protocol.complete_writes();
+  authenticate(protocol, device);
+  run(protocol, 300);
+  for (auto &write : protocol.writes) {
+    deliver(protocol, device.respond(write.data(), write.size()));
+  }
+  protocol.complete_writes();
+  CHECK(protocol.ready());
+}
+
+void test_lockout_and_back_off() {
+  AuthProtocol protocol;
+  FakeSoftener device;
+  device.firmware_major = 5;
+  start(protocol);
+
+  for (uint8_t attempt = 1; attempt <= 3; attempt++) {
+    protocol.writes.clear();
+    rejected_attempt(protocol, device);
+    CHECK(protocol.auth_failures() == attempt);
+    CHECK(protocol.warning());
+    // Retried at once until the last attempt
+    CHECK(count_writes(protocol, is_handshake_request) == (attempt < 3 ? 1u : 0u));
+  }
+  CHECK(protocol.auth_backoff_ms() == AUTH_BACKOFF_MS);
+
+  // Reconnects during the back-off handshake but do not send the password
+  protocol.writes.clear();
+  authenticate(protocol, device);
+  run(protocol, 10000);
+  CHECK(count_writes(protocol, is_auth_packet) == 0);
+  CHECK(protocol.awaiting_handshake());
+
+  // After the back-off: a fresh set of attempts
+  run(protocol, AUTH_BACKOFF_MS);
+  rejected_attempt(protocol, device);
+  CHECK(count_writes(protocol, is_auth_packet) == 1);
+  CHECK(protocol.auth_failures() == 1);
+  rejected_attempt(protocol, device);
+  rejected_attempt(protocol, device);
+  CHECK(protocol.auth_backoff_ms() == 2 * AUTH_BACKOFF_MS);  // Consecutive lockouts double
+
+  // Password fixed on the device side: the next attempt after the back-off succeeds
+  run(protocol, 2 * AUTH_BACKOFF_MS);
+  protocol.writes.clear();
+  authenticate(protocol, device);
+  run(protocol, 300);
+  std::vector<std::vector<uint8_t>> requests = protocol.writes;
+  for (auto &write : requests) {
+    deliver(protocol, device.respond(write.data(), write.size()));
+  }
+  protocol.complete_writes();
+  CHECK(protocol.ready());
+  CHECK(protocol.auth_failures() == 0);
+  CHECK(protocol.auth_backoff_ms() == 0);
+  CHECK(!protocol.warning());
+}
+
+}  // namespace
+
+int main() {
+  test_dropped_auth_write();
+  test_lockout_and_back_off();
+  if (failures > 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("authentication: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * Decoding with a partial entity selection
+ *
+ * Linked against culligan_host_selected, built as code generation builds a
+ * configuration with a few entities: CULLIGAN_ENTITY_SELECTION plus
+ * CULLIGAN_USE_<id> for the battery level, the usage history and the
+ * diagnostic counters only. Polls the simulated softener and checks that
+ * the selected decoders publish, the compiled-out ones stay silent, and
+ * that an errant average daily usage is still counted by the diagnostics
+ * without its sensor.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "fake_softener.h"
+#include "host_protocol.h"
+#include "host_runtime.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+const uint32_t POLL_INTERVAL_MS = 60000;
+
+class SelectedProtocol : public HostProtocol {
+ public:
+  void feed_daily_usage(const uint8_t *history) { this->parse_statistics_daily_usage(history); }
+  uint16_t counter(DiagnosticCounter counter) const { return this->diagnostic_counters_[counter]; }
+};
+
+void deliver(SelectedProtocol &protocol, const FakeSoftener &device, uint8_t family) {
+  uint8_t request[20];
+  std::fill_n(request, sizeof(request), family);
+  for (auto &notification : device.respond(request, sizeof(request))) {
+    protocol.handle_notification(notification.data(), notification.size());
+    protocol.complete_writes();
+  }
+}
+
+}  // namespace
+
+int main() {
+  set_millis(1000);
+  SelectedProtocol protocol;
+  protocol.record_writes = false;
+  protocol.attach_all_entities();
+  protocol.setup();
+  protocol.set_link_connected(true);
+  protocol.send_handshake_request();
+  protocol.complete_writes();
+
+  FakeSoftener device;
+  deliver(protocol, device, 0x74);
+  for (int poll = 0; poll < 3; poll++) {
+    advance_millis(POLL_INTERVAL_MS);
+    protocol.loop();
+    protocol.request_data();
+    protocol.complete_writes();
+    for (uint8_t family : {0x75, 0x76, 0x77}) {
+      deliver(protocol, device, family);
+    }
+    device.tick();
+  }
+
+  // Selected: decoded and published
+  CHECK(protocol.sensor_sinks[SENSOR_BATTERY_LEVEL].publish_count > 0);
+  CHECK(protocol.text_sensor_sinks[TEXT_SENSOR_USAGE_HISTORY].publish_count > 0);
+  // Not selected: the decoding is compiled out, even with a sink attached
+  CHECK(protocol.text_sensor_sinks[TEXT_SENSOR_DEVICE_TIME].publish_count == 0);
+  CHECK(protocol.text_sensor_sinks[TEXT_SENSOR_PEAK_FLOW_HISTORY].publish_count == 0);
+  for (uint8_t i = 0; i < USAGE_WINDOW_COUNT * USAGE_STAT_COUNT; i++) {
+    CHECK(protocol.sensor_sinks[SENSOR_USAGE_STAT + i].publish_count == 0);
+  }
+  // Entities that are always decoded keep working
+  CHECK(protocol.sensor_sinks[SENSOR_WATER_HARDNESS].state == 18.0f);
+
+  // 255 × 10 gallons every day is over the plausible average: rejected and
+  // counted, although the average has no sensor in this selection
+  uint16_t rejects = protocol.counter(DIAG_REJECTS_AVG_DAILY_USAGE);
+  uint8_t errant[frames::DAILY_USAGE_DAYS];
+  memset(errant, 0xFF, sizeof(errant));
+  protocol.feed_daily_usage(errant);
+  CHECK(protocol.counter(DIAG_REJECTS_AVG_DAILY_USAGE) == rejects + 1);
+
+  if (failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("entity selection: selected entities decoded, diagnostics counted\n");
+  return 0;
+}
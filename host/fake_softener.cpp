@@ -0,0 +1,170 @@
+#include "fake_softener.h"
+
+namespace esphome {
+namespace host {
+
+static Notification filled(uint8_t header, uint8_t number, size_t length, uint8_t marker) {
+  Notification frame(length, 0);
+  frame[0] = header;
+  frame[1] = header;
+  frame[2] = number;
+  frame[length - 1] = marker;
+  return frame;
+}
+
+static bool all_bytes(const uint8_t *write, size_t length, uint8_t value) {
+  for (size_t i = 0; i < length; i++) {
+    if (write[i] != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<Notification> FakeSoftener::respond(const uint8_t *write, size_t length) const {
+  std::vector<Notification> out;
+  if (length != 20) {
+    return out;
+  }
+  // Requests repeat the family byte; anything else is a command or the auth packet
+  if (all_bytes(write, length, 0x74)) {
+    out.push_back(this->handshake());
+  } else if (all_bytes(write, length, 0x75)) {
+    this->status(out);
+  } else if (all_bytes(write, length, 0x76)) {
+    this->settings(out);
+  } else if (all_bytes(write, length, 0x77)) {
+    this->statistics(out);
+  }
+  return out;
+}
+
+void FakeSoftener::tick() {
+  this->minutes = (this->minutes + 1) % (24 * 60);
+  // A few minutes of running water every quarter hour
+  this->flow_centi_gpm = (this->minutes % 15) < 3 ? 125 + (this->minutes % 7) * 10 : 0;
+  if (this->flow_centi_gpm > 0) {
+    this->usage_today += 1;
+    this->total_gallons += 1;
+  }
+  if (this->minutes == 0) {
+    this->usage_today = 0;
+    this->days_until_regen = this->days_until_regen > 0 ? this->days_until_regen - 1 : 7;
+  }
+}
+
+Notification FakeSoftener::handshake() const {
+  return {0x74, 0x74, 0x00, 0x01, 0x00, this->firmware_major, this->firmware_minor, 0x00, 0x04,
+          0x03, 0x00, this->connection_counter, 0x00, 0x00, 0x71, 0x47, 0x78, 0x00};
+}
+
+void FakeSoftener::status(std::vector<Notification> &out) const {
+  uint8_t hour = (this->minutes / 60) % 12;
+  Notification uu0 = filled(0x75, 0, 20, 0x39);
+  uu0[3] = hour == 0 ? 12 : hour;
+  uu0[4] = this->minutes % 60;
+  uu0[5] = this->minutes >= 12 * 60 ? 1 : 0;
+  uu0[6] = 100;  // Battery
+  uu0[7] = this->flow_centi_gpm >> 8;
+  uu0[8] = this->flow_centi_gpm & 0xFF;
+  uu0[9] = 0x04;  // Soft water remaining: 1200 gal
+  uu0[10] = 0xB0;
+  uu0[11] = this->usage_today >> 8;
+  uu0[12] = this->usage_today & 0xFF;
+  uu0[13] = 0x01;  // Peak flow today: 3.00 GPM
+  uu0[14] = 0x2C;
+  uu0[15] = 18;  // Hardness
+  uu0[16] = 2;   // Regen at 2 AM
+  uu0[17] = 0;
+  uu0[18] = 0x18;  // Flags
+  out.push_back(uu0);
+
+  Notification uu1 = filled(0x75, 1, 20, 0x3A);
+  uu1[3] = 10;
+  uu1[4] = 5;
+  uu1[13] = 4;   // Regens remaining
+  uu1[14] = 2;   // Low salt alert
+  uu1[15] = 16;  // Tank type
+  uu1[16] = 24;  // Fill height
+  uu1[17] = 15;  // Refill time
+  out.push_back(uu1);
+
+  // uu-2 and its three headerless continuations, each ending in its marker
+  Notification uu2 = filled(0x75, 2, 20, 0x3B);
+  for (int i = 3; i < 19; i++) {
+    uu2[i] = i;
+  }
+  out.push_back(uu2);
+  static const uint8_t CONTINUATION_MARKERS[] = {0x3C, 0x3D, 0x3E};
+  for (uint8_t marker : CONTINUATION_MARKERS) {
+    Notification continuation(20, marker - 0x30);
+    continuation[19] = marker;
+    out.push_back(continuation);
+  }
+}
+
+void FakeSoftener::settings(std::vector<Notification> &out) const {
+  Notification vv0 = filled(0x76, 0, 20, 0x42);
+  vv0[3] = this->days_until_regen;
+  vv0[4] = 7;
+  vv0[5] = 25;  // Reserve capacity
+  vv0[7] = 32;  // Resin capacity, thousands of grains
+  vv0[10] = 14;
+  vv0[12] = 1;
+  vv0[13] = 2;
+  vv0[14] = 8;
+  vv0[16] = 0x10;
+  out.push_back(vv0);
+
+  Notification vv1 = filled(0x76, 1, 20, 0x43);
+  static const uint8_t POSITIONS[] = {0x8A, 60, 10, 12, 0, 0, 0, 0x85};
+  for (int i = 0; i < 8; i++) {
+    vv1[3 + i] = POSITIONS[i];
+  }
+  out.push_back(vv1);
+  out.push_back(filled(0x76, 2, 20, 0x44));
+  out.push_back(filled(0x76, 3, 20, 0x45));
+}
+
+void FakeSoftener::statistics(std::vector<Notification> &out) const {
+  Notification ww0 = filled(0x77, 0, 19, 0x46);
+  ww0[3] = this->flow_centi_gpm >> 8;
+  ww0[4] = this->flow_centi_gpm & 0xFF;
+  ww0[5] = this->total_gallons >> 16;
+  ww0[6] = this->total_gallons >> 8;
+  ww0[7] = this->total_gallons & 0xFF;
+  ww0[9] = 0x27;  // Resettable: 10000 gal
+  ww0[10] = 0x10;
+  ww0[12] = 120;  // Total regens
+  ww0[14] = 12;
+  out.push_back(ww0);
+
+  // ww-1 and three continuations: 62 days of usage, today last
+  uint8_t days[62];
+  for (int i = 0; i < 62; i++) {
+    days[i] = 10 + (i * 7) % 13;
+  }
+  days[61] = this->usage_today / 10;
+  Notification ww1 = filled(0x77, 1, 20, 0);
+  for (int i = 0; i < 17; i++) {
+    ww1[3 + i] = days[i];
+  }
+  out.push_back(ww1);
+  out.emplace_back(days + 17, days + 37);
+  out.emplace_back(days + 37, days + 57);
+  Notification tail(days + 57, days + 62);
+  tail.push_back(0x38);
+  out.push_back(tail);
+
+  Notification ww2 = filled(0x77, 2, 20, 0x48);
+  Notification ww3 = filled(0x77, 3, 20, 0x49);
+  for (int i = 3; i < 19; i++) {
+    ww2[i] = 20 + i;
+    ww3[i] = i % 4;
+  }
+  out.push_back(ww2);
+  out.push_back(ww3);
+}
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,45 @@
+/**
+ * Simulated CS Meter Soft
+ *
+ * Answers the component's 20-byte writes with the notifications a real
+ * softener sends (PROTOCOL.md): the tt handshake, the uu/vv/ww bursts
+ * including their headerless continuations, and nothing for keepalives
+ * and commands. tick() moves the device on by one minute so consecutive
+ * polls carry changing values.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace host {
+
+using Notification = std::vector<uint8_t>;
+
+class FakeSoftener {
+ public:
+  // Notifications answering one write, in the order the device sends them
+  std::vector<Notification> respond(const uint8_t *write, size_t length) const;
+  void tick();
+
+  uint8_t firmware_major{6};  // 6 and later: no authentication
+  uint8_t firmware_minor{0x12};
+  uint8_t connection_counter{0x36};
+  uint32_t minutes{7 * 60};   // Device clock, minutes since midnight
+  uint16_t flow_centi_gpm{0};
+  uint16_t usage_today{0};
+  uint32_t total_gallons{100000};
+  uint8_t days_until_regen{5};
+
+ protected:
+  Notification handshake() const;
+  void status(std::vector<Notification> &out) const;
+  void settings(std::vector<Notification> &out) const;
+  void statistics(std::vector<Notification> &out) const;
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,107 @@
+/**
+ * CulliganProtocol with an in-memory transport
+ *
+ * Writes are recorded and completed on request instead of going to a radio,
+ * and every entity can be attached to a sink in one call.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "culligan_protocol.h"
+
+namespace esphome {
+namespace host {
+
+using namespace culligan_water_softener;
+
+class HostProtocol : public CulliganProtocol {
+ public:
+  // Attach a sink to every sensor, text sensor, binary sensor and number id
+  void attach_all_entities() {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      this->set_sensor(static_cast<SensorId>(i), &this->sensor_sinks[i]);
+    }
+    for (size_t i = 0; i < TEXT_SENSOR_COUNT; i++) {
+      this->set_text_sensor(static_cast<TextSensorId>(i), &this->text_sensor_sinks[i]);
+    }
+    for (size_t i = 0; i < BINARY_SENSOR_COUNT; i++) {
+      this->set_binary_sensor(static_cast<BinarySensorId>(i), &this->binary_sensor_sinks[i]);
+    }
+    for (size_t i = 0; i < NUMBER_COUNT; i++) {
+      this->set_number(static_cast<NumberId>(i), &this->number_sinks[i]);
+    }
+  }
+
+  // Report every publish as "<platform> <id>: <state>", in publish order
+  void record_publishes(const std::function<void(const std::string &)> &out) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      this->sensor_sinks[i].add_on_state_callback([out, i](float state) { out(format_state("sensor", i, state)); });
+    }
+    for (size_t i = 0; i < TEXT_SENSOR_COUNT; i++) {
+      this->text_sensor_sinks[i].add_on_state_callback(
+          [out, i](const std::string &state) { out("text_sensor " + std::to_string(i) + ": \"" + state + "\""); });
+    }
+    for (size_t i = 0; i < BINARY_SENSOR_COUNT; i++) {
+      this->binary_sensor_sinks[i].add_on_state_callback(
+          [out, i](bool state) { out("binary_sensor " + std::to_string(i) + (state ? ": ON" : ": OFF")); });
+    }
+    for (size_t i = 0; i < NUMBER_COUNT; i++) {
+      this->number_sinks[i].add_on_state_callback([out, i](float state) { out(format_state("number", i, state)); });
+    }
+  }
+
+  // Publishes across all sinks so far
+  uint32_t publish_count() const {
+    uint32_t count = 0;
+    for (auto &sink : this->sensor_sinks) count += sink.publish_count;
+    for (auto &sink : this->text_sensor_sinks) count += sink.publish_count;
+    for (auto &sink : this->binary_sensor_sinks) count += sink.publish_count;
+    for (auto &sink : this->number_sinks) count += sink.publish_count;
+    return count;
+  }
+
+  // Acknowledge every queued write, as the GATT stack would one by one
+  void complete_writes() {
+    while (this->write_in_flight_) {
+      this->on_write_complete(true);
+    }
+  }
+
+  // Report the write in flight as failed; the queue retries it after a delay
+  void fail_write() {
+    if (this->write_in_flight_) {
+      this->on_write_complete(false);
+    }
+  }
+  bool write_in_flight() const { return this->write_in_flight_; }
+
+  bool write_command(const uint8_t *data, size_t length) override {
+    if (this->record_writes) {
+      this->writes.emplace_back(data, data + length);
+    }
+    return true;
+  }
+
+  static std::string format_state(const char *platform, size_t id, float state) {
+    char text[64];
+    snprintf(text, sizeof(text), "%s %u: %g", platform, static_cast<unsigned>(id), state);
+    return text;
+  }
+
+  bool record_writes{true};
+  std::vector<std::vector<uint8_t>> writes;
+  sensor::Sensor sensor_sinks[SENSOR_COUNT];
+  text_sensor::TextSensor text_sensor_sinks[TEXT_SENSOR_COUNT];
+  binary_sensor::BinarySensor binary_sensor_sinks[BINARY_SENSOR_COUNT];
+  HardnessNumber number_sinks[NUMBER_COUNT];
+};
+
+}  // namespace host
+}  // namespace esphome
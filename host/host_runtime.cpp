@@ -0,0 +1,150 @@
+#include "host_runtime.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace {
+uint32_t current_ms = 0;
+bool log_echo = false;
+std::string *log_capture = nullptr;
+uint32_t log_lines = 0;
+uint64_t allocations = 0;
+}  // namespace
+
+void *operator new(size_t size) {
+  allocations++;
+  void *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void *operator new[](size_t size) { return ::operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace esphome {
+
+namespace setup_priority {
+const float DATA = 600.0f;
+const float AFTER_BLUETOOTH = 700.0f;
+}  // namespace setup_priority
+
+uint32_t millis() { return current_ms; }
+uint32_t micros() { return current_ms * 1000; }
+void delay(uint32_t ms) { current_ms += ms; }
+
+uint32_t random_uint32() {
+  // Deterministic, so runs are reproducible
+  static uint32_t state = 2463534242u;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261u;
+  for (char c : str) {
+    hash *= 16777619u;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+std::string format_hex(const uint8_t *data, size_t length) {
+  static const char DIGITS[] = "0123456789abcdef";
+  std::string out;
+  out.reserve(length * 2);
+  for (size_t i = 0; i < length; i++) {
+    out += DIGITS[data[i] >> 4];
+    out += DIGITS[data[i] & 0x0F];
+  }
+  return out;
+}
+
+std::string format_hex_pretty(const uint8_t *data, size_t length) {
+  static const char DIGITS[] = "0123456789ABCDEF";
+  std::string out;
+  for (size_t i = 0; i < length; i++) {
+    if (i > 0) {
+      out += '.';
+    }
+    out += DIGITS[data[i] >> 4];
+    out += DIGITS[data[i] & 0x0F];
+  }
+  return out;
+}
+
+static ESPPreferences host_preferences;
+ESPPreferences *global_preferences = &host_preferences;
+
+namespace host {
+
+void set_millis(uint32_t ms) { current_ms = ms; }
+void advance_millis(uint32_t ms) { current_ms += ms; }
+
+void set_log_echo(bool echo) { log_echo = echo; }
+uint32_t log_line_count() { return log_lines; }
+void set_log_capture(std::string *out) { log_capture = out; }
+
+void log_line(int level, const char *tag, const char *format, ...) {
+  log_lines++;
+  if (!log_echo && log_capture == nullptr) {
+    return;
+  }
+  static const char LEVELS[] = "?EWICDVV";
+  char message[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  if (log_echo) {
+    fprintf(stderr, "[%c][%s]: %s\n", LEVELS[level & 7], tag, message);
+  }
+  if (log_capture != nullptr) {
+    *log_capture += '[';
+    *log_capture += LEVELS[level & 7];
+    *log_capture += "][";
+    *log_capture += tag;
+    *log_capture += "]: ";
+    *log_capture += message;
+    *log_capture += '\n';
+  }
+}
+
+uint64_t allocation_count() { return allocations; }
+
+GattcHooks &gattc_hooks() {
+  static GattcHooks hooks;
+  return hooks;
+}
+
+}  // namespace host
+}  // namespace esphome
+
+using esphome::host::gattc_hooks;
+
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t, uint16_t handle) {
+  return gattc_hooks().register_for_notify ? gattc_hooks().register_for_notify(gattc_if, handle) : ESP_FAIL;
+}
+
+esp_err_t esp_ble_gattc_write_char(esp_gatt_if_t gattc_if, uint16_t, uint16_t handle, uint16_t value_len,
+                                   uint8_t *value, esp_gatt_write_type_t, esp_gatt_auth_req_t) {
+  return gattc_hooks().write_char ? gattc_hooks().write_char(gattc_if, handle, value, value_len) : ESP_FAIL;
+}
+
+esp_err_t esp_ble_gattc_write_char_descr(esp_gatt_if_t gattc_if, uint16_t, uint16_t handle, uint16_t value_len,
+                                         uint8_t *value, esp_gatt_write_type_t, esp_gatt_auth_req_t) {
+  return gattc_hooks().write_descr ? gattc_hooks().write_descr(gattc_if, handle, value, value_len) : ESP_FAIL;
+}
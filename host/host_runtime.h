@@ -0,0 +1,42 @@
+/**
+ * Host runtime for the Culligan component
+ *
+ * Supplies what ESPHome's core provides on a device: a clock (simulated,
+ * advanced by the caller), logging, preferences and the ESP-IDF GATT client
+ * calls. It also counts log lines and heap allocations for the benchmarks.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/components/esp32_ble_tracker/esp32_ble_tracker.h"
+
+namespace esphome {
+namespace host {
+
+// Simulated clock behind millis()/micros()/delay()
+void set_millis(uint32_t ms);
+void advance_millis(uint32_t ms);
+
+// Log lines at or below ESPHOME_LOG_LEVEL; echoed to stderr when enabled
+void set_log_echo(bool echo);
+uint32_t log_line_count();
+// Also append each line, formatted as ESPHome's logger does, to out (nullptr: stop)
+void set_log_capture(std::string *out);
+
+// Calls to the global operator new since start
+uint64_t allocation_count();
+
+// GATT client calls made by the transport; unset hooks fail with ESP_FAIL
+struct GattcHooks {
+  std::function<esp_err_t(esp_gatt_if_t gattc_if, uint16_t handle)> register_for_notify;
+  std::function<esp_err_t(esp_gatt_if_t gattc_if, uint16_t handle, const uint8_t *value, uint16_t length)> write_char;
+  std::function<esp_err_t(esp_gatt_if_t gattc_if, uint16_t handle, const uint8_t *value, uint16_t length)> write_descr;
+};
+GattcHooks &gattc_hooks();
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,49 @@
+/**
+ * Log lines per poll in steady state
+ *
+ * One softener stays connected to a simulated device. After a warm-up the
+ * program counts the log lines emitted (at ESPHome's default DEBUG level)
+ * per status poll, transport included. Built once as is and once with
+ * quiet_decode (log_count_quiet). Exits non-zero when the count is above
+ * max, if given; echo prints the counted lines.
+ *
+ *   log_count [polls] [max] [echo]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "host_runtime.h"
+#include "sim_radio.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+int main(int argc, char **argv) {
+  uint32_t polls = argc > 1 ? strtoul(argv[1], nullptr, 10) : 30;
+  double max = argc > 2 ? strtod(argv[2], nullptr) : -1.0;
+  if (argc > 3) {
+    set_log_echo(true);
+  }
+
+  set_millis(1000);
+  SimRadio radio(1);
+  auto &link = radio.add(0xC0FFEE000001ULL);
+  // No water flow: every poll is a regular one
+  link.device.minutes = 20 * 60 + 5;
+  radio.start();
+  radio.run(5 * 60 * 1000);  // Connect, first full refresh and a few polls
+
+  uint32_t requests = link.status_requests;
+  uint32_t lines = log_line_count();
+  while (link.status_requests - requests < polls) {
+    radio.run(1000);
+  }
+  double per_poll = static_cast<double>(log_line_count() - lines) / (link.status_requests - requests);
+  printf("log lines/poll: %.2f (%u polls)\n", per_poll, link.status_requests - requests);
+  if (max >= 0.0 && per_poll > max) {
+    fprintf(stderr, "expected at most %.2f log lines/poll\n", max);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * Replay benchmark for the protocol core
+ *
+ * Records the notifications of a number of poll cycles from the simulated
+ * softener, then feeds them through CulliganProtocol with every entity
+ * attached and reports the decode cost per notification.
+ *
+ *   replay_bench [polls]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "fake_softener.h"
+#include "host_protocol.h"
+#include "host_runtime.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+const uint32_t POLL_INTERVAL_MS = 60000;
+
+struct Poll {
+  std::vector<Notification> notifications;
+};
+
+std::vector<Poll> record_polls(size_t count) {
+  FakeSoftener device;
+  std::vector<Poll> polls(count);
+  const uint8_t families[] = {0x75, 0x76, 0x77};
+  for (auto &poll : polls) {
+    for (uint8_t family : families) {
+      uint8_t request[20];
+      std::fill_n(request, sizeof(request), family);
+      for (auto &notification : device.respond(request, sizeof(request))) {
+        poll.notifications.push_back(std::move(notification));
+      }
+    }
+    device.tick();
+  }
+  return polls;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t poll_count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+  if (poll_count < 2) {
+    fprintf(stderr, "usage: %s [polls >= 2]\n", argv[0]);
+    return 2;
+  }
+  std::vector<Poll> polls = record_polls(poll_count);
+
+  set_millis(1000);
+  HostProtocol protocol;
+  protocol.record_writes = false;
+  protocol.attach_all_entities();
+  protocol.setup();
+  protocol.set_link_connected(true);
+  protocol.send_handshake_request();
+  protocol.complete_writes();
+  FakeSoftener device;
+  uint8_t handshake_request[20];
+  std::fill_n(handshake_request, sizeof(handshake_request), 0x74);
+  for (auto &notification : device.respond(handshake_request, sizeof(handshake_request))) {
+    protocol.handle_notification(notification.data(), notification.size());
+  }
+  protocol.complete_writes();
+
+  // The first poll publishes every entity and sizes the strings: not steady state
+  size_t notifications = 0;
+  size_t bytes = 0;
+  uint64_t allocations = 0;
+  uint32_t publishes = 0;
+  std::chrono::nanoseconds elapsed{0};
+  for (size_t i = 0; i < polls.size(); i++) {
+    advance_millis(POLL_INTERVAL_MS);
+    protocol.loop();
+    protocol.request_data();
+    protocol.complete_writes();
+
+    uint64_t allocations_before = allocation_count();
+    uint32_t publishes_before = protocol.publish_count();
+    auto start = std::chrono::steady_clock::now();
+    for (auto &notification : polls[i].notifications) {
+      protocol.handle_notification(notification.data(), notification.size());
+      protocol.complete_writes();
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (i == 0) {
+      continue;
+    }
+    elapsed += end - start;
+    allocations += allocation_count() - allocations_before;
+    publishes += protocol.publish_count() - publishes_before;
+    notifications += polls[i].notifications.size();
+    for (auto &notification : polls[i].notifications) {
+      bytes += notification.size();
+    }
+  }
+
+  // Decoding must have kept up with the device, or the figures are meaningless
+  const auto &hardness = protocol.sensor_sinks[SENSOR_WATER_HARDNESS];
+  const auto &history = protocol.text_sensor_sinks[TEXT_SENSOR_USAGE_HISTORY];
+  if (!hardness.has_state() || hardness.state != 18.0f || !history.has_state()) {
+    fprintf(stderr, "decode check failed\n");
+    return 1;
+  }
+
+  double ns = static_cast<double>(elapsed.count());
+  printf("polls:              %zu (%zu notifications, %zu bytes measured)\n", poll_count - 1, notifications, bytes);
+  printf("ns/packet:          %.1f\n", ns / notifications);
+  printf("bytes/s:            %.0f\n", bytes / (ns / 1e9));
+  printf("allocs/packet:      %.3f\n", static_cast<double>(allocations) / notifications);
+  printf("publishes/packet:   %.3f\n", static_cast<double>(publishes) / notifications);
+  return 0;
+}
@@ -0,0 +1,193 @@
+#include "sim_radio.h"
+
+#include <algorithm>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
+#include "host_runtime.h"
+
+namespace esphome {
+namespace host {
+
+// NUS characteristic handles the simulated devices expose
+static const uint16_t TX_HANDLE = 0x000E;
+static const uint16_t TX_CCCD_HANDLE = 0x000F;
+static const uint16_t RX_HANDLE = 0x0011;
+
+SimSoftener::~SimSoftener() {
+  auto &instances = CulliganWaterSoftener::instances_;
+  instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+}
+
+SimRadio::SimRadio(uint8_t max_connections, uint32_t connect_ms, uint32_t latency_ms)
+    : max_connections(max_connections), connect_ms(connect_ms), latency_ms(latency_ms) {
+  host_preference_store().clear();
+  auto &hooks = gattc_hooks();
+  hooks.register_for_notify = [this](esp_gatt_if_t gattc_if, uint16_t handle) {
+    Link *link = this->link_for(gattc_if);
+    if (link == nullptr || !link->connected || handle != TX_HANDLE) {
+      return ESP_FAIL;
+    }
+    this->schedule(gattc_if - 1, ESP_GATTC_REG_FOR_NOTIFY_EVT, handle);
+    return ESP_OK;
+  };
+  hooks.write_descr = [this](esp_gatt_if_t gattc_if, uint16_t handle, const uint8_t *, uint16_t) {
+    Link *link = this->link_for(gattc_if);
+    if (link == nullptr || !link->connected) {
+      return ESP_FAIL;
+    }
+    this->schedule(gattc_if - 1, ESP_GATTC_WRITE_DESCR_EVT, handle);
+    return ESP_OK;
+  };
+  hooks.write_char = [this](esp_gatt_if_t gattc_if, uint16_t handle, const uint8_t *value, uint16_t length) {
+    Link *link = this->link_for(gattc_if);
+    if (link == nullptr || !link->connected || handle != RX_HANDLE) {
+      return ESP_FAIL;
+    }
+    this->schedule(gattc_if - 1, ESP_GATTC_WRITE_CHAR_EVT, handle);
+    if (length == 20 && value[0] == 0x75 && value[19] == 0x75) {
+      link->status_requests++;
+    }
+    for (auto &notification : link->device.respond(value, length)) {
+      this->schedule(gattc_if - 1, ESP_GATTC_NOTIFY_EVT, TX_HANDLE, std::move(notification));
+    }
+    return ESP_OK;
+  };
+}
+
+SimRadio::~SimRadio() { gattc_hooks() = GattcHooks{}; }
+
+SimRadio::Link &SimRadio::add(uint64_t address) {
+  this->links.push_back(std::unique_ptr<Link>(new Link()));
+  Link &link = *this->links.back();
+  size_t index = this->links.size() - 1;
+
+  link.client.set_gattc_if(static_cast<esp_gatt_if_t>(index + 1));
+  link.client.set_address(address);
+  link.client.enabled = true;
+  auto nus = esp32_ble_tracker::ESPBTUUID::from_raw("6e400001-b5a3-f393-e0a9-e50e24dcca9e");
+  ble_client::BLECharacteristic tx;
+  tx.service = nus;
+  tx.uuid = esp32_ble_tracker::ESPBTUUID::from_raw("6e400003-b5a3-f393-e0a9-e50e24dcca9e");
+  tx.handle = TX_HANDLE;
+  tx.descriptors.push_back({esp32_ble_tracker::ESPBTUUID::from_uint16(0x2902), TX_CCCD_HANDLE});
+  ble_client::BLECharacteristic rx;
+  rx.service = nus;
+  rx.uuid = esp32_ble_tracker::ESPBTUUID::from_raw("6e400002-b5a3-f393-e0a9-e50e24dcca9e");
+  rx.handle = RX_HANDLE;
+  link.client.characteristics = {tx, rx};
+
+  link.softener.set_ble_client_parent(&link.client);
+  link.softener.set_auto_discover(false);
+  link.softener.set_cache_key("softener_" + std::to_string(index));
+  link.device.minutes += static_cast<uint32_t>(index) * 7;  // Devices out of step
+  return link;
+}
+
+void SimRadio::start() {
+  for (auto &link : this->links) {
+    link->softener.setup();
+  }
+}
+
+void SimRadio::run(uint32_t duration_ms, uint32_t step_ms) {
+  uint32_t end = millis() + duration_ms;
+  while (static_cast<int32_t>(end - millis()) > 0) {
+    this->step(millis());
+    for (auto &link : this->links) {
+      link->softener.loop();
+    }
+    advance_millis(step_ms);
+  }
+}
+
+void SimRadio::step(uint32_t now) {
+  for (size_t i = 0; i < this->links.size(); i++) {
+    Link &link = *this->links[i];
+    if (!link.client.enabled && (link.connected || link.connecting)) {
+      // Drop whatever was still in flight for this link
+      this->events_.erase(std::remove_if(this->events_.begin(), this->events_.end(),
+                                         [i](const Event &event) { return event.link == i; }),
+                          this->events_.end());
+      bool was_connected = link.connected;
+      link.connected = false;
+      link.connecting = false;
+      if (was_connected) {
+        esp_ble_gattc_cb_param_t param{};
+        link.softener.gattc_event_handler(ESP_GATTC_DISCONNECT_EVT, link.client.get_gattc_if(), &param);
+      }
+    } else if (link.client.enabled && !link.connected && !link.connecting &&
+               this->connected_count() < this->max_connections) {
+      link.connecting = true;
+      link.connect_time = now + this->connect_ms;
+    } else if (link.connecting && static_cast<int32_t>(now - link.connect_time) >= 0) {
+      link.connecting = false;
+      link.connected = true;
+      link.connections++;
+      this->peak_connections = std::max(this->peak_connections, this->connected_count());
+      esp_ble_gattc_cb_param_t param{};
+      param.open.status = ESP_GATT_OK;
+      link.softener.gattc_event_handler(ESP_GATTC_OPEN_EVT, link.client.get_gattc_if(), &param);
+      this->schedule(i, ESP_GATTC_SEARCH_CMPL_EVT, 0);
+    }
+  }
+
+  while (!this->events_.empty() && static_cast<int32_t>(now - this->events_.front().time) >= 0) {
+    Event event = std::move(this->events_.front());
+    this->events_.pop_front();
+    this->deliver(event);
+  }
+}
+
+void SimRadio::deliver(const Event &event) {
+  Link &link = *this->links[event.link];
+  if (!link.connected) {
+    return;
+  }
+  esp_ble_gattc_cb_param_t param{};
+  switch (event.type) {
+    case ESP_GATTC_REG_FOR_NOTIFY_EVT:
+      param.reg_for_notify.status = ESP_GATT_OK;
+      param.reg_for_notify.handle = event.handle;
+      break;
+    case ESP_GATTC_WRITE_CHAR_EVT:
+    case ESP_GATTC_WRITE_DESCR_EVT:
+      param.write.status = ESP_GATT_OK;
+      param.write.handle = event.handle;
+      break;
+    case ESP_GATTC_NOTIFY_EVT:
+      param.notify.handle = event.handle;
+      param.notify.value_len = static_cast<uint16_t>(event.value.size());
+      param.notify.value = const_cast<uint8_t *>(event.value.data());
+      param.notify.is_notify = true;
+      break;
+    default:
+      break;
+  }
+  link.softener.gattc_event_handler(event.type, link.client.get_gattc_if(), &param);
+}
+
+void SimRadio::schedule(size_t link, esp_gattc_cb_event_t type, uint16_t handle, std::vector<uint8_t> value) {
+  // Events of one link keep their order; a single latency keeps the queue sorted
+  this->events_.push_back({millis() + this->latency_ms, link, type, handle, std::move(value)});
+}
+
+SimRadio::Link *SimRadio::link_for(esp_gatt_if_t gattc_if) {
+  if (gattc_if == 0 || gattc_if > this->links.size()) {
+    return nullptr;
+  }
+  return this->links[gattc_if - 1].get();
+}
+
+uint8_t SimRadio::connected_count() const {
+  uint8_t count = 0;
+  for (auto &link : this->links) {
+    if (link->connected || link->connecting) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace host
+}  // namespace esphome
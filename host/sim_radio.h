@@ -0,0 +1,81 @@
+/**
+ * Simulated BLE radio for CulliganWaterSoftener
+ *
+ * Connects each transport to its own FakeSoftener through the ble_client
+ * stand-in: enabling a client opens a connection after a delay (if the
+ * controller has a free connection), discovery and notification
+ * registration follow, and writes are answered by the device as GATT
+ * events after a fixed latency. Disabling a client disconnects it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "culligan_water_softener.h"
+#include "fake_softener.h"
+
+namespace esphome {
+namespace host {
+
+using culligan_water_softener::CulliganWaterSoftener;
+
+// Transport under simulation: leaves the instance list on destruction
+class SimSoftener : public CulliganWaterSoftener {
+ public:
+  ~SimSoftener() override;
+  bool slot_held() const { return this->slot_held_; }
+};
+
+class SimRadio {
+ public:
+  struct Link {
+    ble_client::BLEClient client;
+    SimSoftener softener;
+    FakeSoftener device;
+    bool connected{false};
+    bool connecting{false};
+    uint32_t connect_time{0};
+    uint32_t status_requests{0};  // 'u' requests the device answered
+    uint32_t connections{0};
+  };
+
+  SimRadio(uint8_t max_connections, uint32_t connect_ms = 1500, uint32_t latency_ms = 30);
+  ~SimRadio();
+
+  // New softener at address, configured but not set up
+  Link &add(uint64_t address);
+  // setup() every softener, then loop() them all every step_ms for duration_ms
+  void start();
+  void run(uint32_t duration_ms, uint32_t step_ms = 10);
+
+  std::vector<std::unique_ptr<Link>> links;
+  uint8_t max_connections;
+  uint32_t connect_ms;
+  uint32_t latency_ms;
+  uint8_t peak_connections{0};
+
+ protected:
+  struct Event {
+    uint32_t time;
+    size_t link;
+    esp_gattc_cb_event_t type;
+    uint16_t handle;
+    std::vector<uint8_t> value;
+  };
+
+  void step(uint32_t now);
+  void deliver(const Event &event);
+  void schedule(size_t link, esp_gattc_cb_event_t type, uint16_t handle, std::vector<uint8_t> value = {});
+  Link *link_for(esp_gatt_if_t gattc_if);
+  uint8_t connected_count() const;
+
+  std::deque<Event> events_;
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,219 @@
+/**
+ * Fake-time tests for the connection slot scheduler
+ *
+ * Drives slot_overdue() and run_slot_scheduler() directly at chosen times,
+ * without a radio: sessions never complete, so a slot is only given back by
+ * the timeout or by release_slot().
+ */
+
+#include <climits>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "esphome/core/preferences.h"
+#include "host_runtime.h"
+#include "sim_radio.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+const uint32_t POLL_INTERVAL_MS = 60000;
+const uint32_t FAST_POLL_INTERVAL_MS = 10000;
+const uint32_t SLOT_TIMEOUT_MS = 30000;
+
+class ProbeSoftener : public SimSoftener {
+ public:
+  int32_t overdue(uint32_t now) const { return this->slot_overdue(now); }
+  void schedule(uint32_t now) { this->run_slot_scheduler(now); }
+  void release(uint32_t now) { this->release_slot(now); }
+  void set_flow_active(bool active) { this->flow_active_ = active; }
+  void hold_command() { this->held_command_count_ = 1; }
+};
+
+struct Unit {
+  Unit(uint64_t address, uint8_t slots) {
+    client.set_address(address);
+    client.enabled = true;
+    softener.set_ble_client_parent(&client);
+    softener.set_auto_discover(false);
+    softener.set_connection_slots(slots);
+    softener.setup();
+  }
+  ble_client::BLEClient client;
+  ProbeSoftener softener;
+};
+
+std::vector<std::unique_ptr<Unit>> make_units(size_t count, uint8_t slots) {
+  host_preference_store().clear();
+  std::vector<std::unique_ptr<Unit>> units;
+  for (size_t i = 0; i < count; i++) {
+    units.emplace_back(new Unit(0xC0FFEE000000ULL + i, slots));
+  }
+  return units;
+}
+
+void test_not_time_sliced() {
+  auto units = make_units(1, 0);
+  CHECK(units[0]->softener.overdue(1000) == -1);
+}
+
+void test_no_address() {
+  auto units = make_units(1, 1);
+  units[0]->client.set_address(0);
+  CHECK(units[0]->softener.overdue(1000) == -1);
+}
+
+void test_first_poll_goes_first() {
+  auto units = make_units(1, 1);
+  auto &softener = units[0]->softener;
+  CHECK(softener.overdue(1000) == INT32_MAX);
+  softener.schedule(1000);
+  CHECK(softener.slot_held());
+  CHECK(units[0]->client.enabled);
+  CHECK(softener.overdue(1000) == -1);
+}
+
+void test_timeout_and_interval() {
+  auto units = make_units(1, 1);
+  auto &softener = units[0]->softener;
+  softener.schedule(1000);
+  softener.schedule(1000 + SLOT_TIMEOUT_MS - 1);
+  CHECK(softener.slot_held());
+  uint32_t released = 1000 + SLOT_TIMEOUT_MS;
+  softener.schedule(released);
+  CHECK(!softener.slot_held());
+  CHECK(!units[0]->client.enabled);
+
+  // Due one poll interval after the release, and more overdue from then on
+  CHECK(softener.overdue(released + POLL_INTERVAL_MS - 1) < 0);
+  CHECK(softener.overdue(released + POLL_INTERVAL_MS) == 0);
+  CHECK(softener.overdue(released + POLL_INTERVAL_MS + 250) == 250);
+  softener.schedule(released + POLL_INTERVAL_MS - 1);
+  CHECK(!softener.slot_held());
+  softener.schedule(released + POLL_INTERVAL_MS);
+  CHECK(softener.slot_held());
+}
+
+void test_fast_interval_while_active() {
+  auto units = make_units(1, 1);
+  auto &softener = units[0]->softener;
+  softener.schedule(1000);
+  softener.set_flow_active(true);
+  softener.release(2000);
+  CHECK(softener.overdue(2000 + FAST_POLL_INTERVAL_MS) == 0);
+
+  // The interval is fixed at release: flow stopping later does not change it
+  softener.set_flow_active(false);
+  CHECK(softener.overdue(2000 + FAST_POLL_INTERVAL_MS) == 0);
+  softener.schedule(3000);
+  softener.release(4000);
+  CHECK(softener.overdue(4000 + FAST_POLL_INTERVAL_MS) < 0);
+  CHECK(softener.overdue(4000 + POLL_INTERVAL_MS) == 0);
+}
+
+void test_held_command_jumps_the_queue() {
+  auto units = make_units(1, 1);
+  auto &softener = units[0]->softener;
+  softener.schedule(1000);
+  softener.release(2000);
+  CHECK(softener.overdue(2001) < 0);
+  softener.hold_command();
+  CHECK(softener.overdue(2001) == INT32_MAX);
+}
+
+void test_waiting_client_stays_disabled() {
+  auto units = make_units(2, 1);
+  units[0]->softener.schedule(1000);
+  units[1]->softener.schedule(1000);
+  CHECK(units[0]->softener.slot_held());
+  CHECK(!units[1]->softener.slot_held());
+  CHECK(!units[1]->client.enabled);
+}
+
+void test_round_robin() {
+  auto units = make_units(3, 1);
+  // Released at 0, 1 and 2 s: the earliest is the most overdue
+  for (size_t i = 0; i < units.size(); i++) {
+    units[i]->softener.schedule(1000 * i);
+    units[i]->softener.release(1000 * i);
+  }
+
+  uint32_t now = 2000 + POLL_INTERVAL_MS;
+  std::vector<size_t> order;
+  for (int turn = 0; turn < 6; turn++) {
+    // Ask in reverse, so the order comes from overdue times and not from who asks first
+    for (size_t i = units.size(); i-- > 0;) {
+      units[i]->softener.schedule(now);
+    }
+    size_t holders = 0;
+    for (size_t i = 0; i < units.size(); i++) {
+      if (units[i]->softener.slot_held()) {
+        holders++;
+        order.push_back(i);
+      }
+    }
+    CHECK(holders == 1);
+    now += 5000;
+    for (auto &unit : units) {
+      if (unit->softener.slot_held()) {
+        unit->softener.release(now);
+      }
+    }
+    now += POLL_INTERVAL_MS;
+  }
+  CHECK((order == std::vector<size_t>{0, 1, 2, 0, 1, 2}));
+}
+
+void test_slots_shared() {
+  auto units = make_units(3, 2);
+  for (auto &unit : units) {
+    unit->softener.schedule(1000);
+  }
+  CHECK(units[0]->softener.slot_held());
+  CHECK(units[1]->softener.slot_held());
+  CHECK(!units[2]->softener.slot_held());
+}
+
+void test_permanent_link_uses_a_slot() {
+  auto units = make_units(3, 2);
+  // Without connection_slots it stays connected: one slot left for the others
+  units[0]->softener.set_connection_slots(0);
+  units[1]->softener.schedule(1000);
+  units[2]->softener.schedule(1000);
+  CHECK(units[1]->softener.slot_held());
+  CHECK(!units[2]->softener.slot_held());
+}
+
+}  // namespace
+
+int main() {
+  test_not_time_sliced();
+  test_no_address();
+  test_first_poll_goes_first();
+  test_timeout_and_interval();
+  test_fast_interval_while_active();
+  test_held_command_jumps_the_queue();
+  test_waiting_client_stays_disabled();
+  test_round_robin();
+  test_slots_shared();
+  test_permanent_link_uses_a_slot();
+  if (failures > 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("slot scheduler: all checks passed\n");
+  return 0;
+}
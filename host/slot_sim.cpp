@@ -0,0 +1,92 @@
+/**
+ * Connection slot simulation: polls per minute against softener count
+ *
+ * Runs 1 to 48 softeners sharing a number of connection slots over the
+ * simulated radio (1.5 s to connect, 30 ms per GATT round trip) and reports
+ * the status polls per minute they achieve together and the spread between
+ * the best- and worst-served softener. Fails if more links were ever open
+ * than there are slots, or if the scheduler starves a softener.
+ *
+ *   slot_sim [slots] [minutes]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "host_runtime.h"
+#include "sim_radio.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+const uint32_t WARM_UP_MS = 2 * 60 * 1000;
+const size_t SOFTENER_COUNTS[] = {1, 2, 4, 8, 16, 24, 32, 48};
+
+struct Result {
+  double polls_per_minute;
+  double min_per_device;  // Polls per minute of the worst-served softener
+  double max_per_device;
+  uint8_t peak_connections;
+};
+
+Result simulate(size_t softeners, uint8_t slots, uint32_t minutes) {
+  set_millis(1000);
+  SimRadio radio(slots);
+  for (size_t i = 0; i < softeners; i++) {
+    auto &link = radio.add(0xC0FFEE000000ULL + i);
+    link.softener.set_connection_slots(slots);
+  }
+  radio.start();
+  radio.run(WARM_UP_MS);
+
+  std::vector<uint32_t> before;
+  for (auto &link : radio.links) {
+    before.push_back(link->status_requests);
+  }
+  radio.run(minutes * 60 * 1000);
+
+  Result result{0.0, 1e9, 0.0, radio.peak_connections};
+  uint32_t total = 0;
+  for (size_t i = 0; i < softeners; i++) {
+    uint32_t polls = radio.links[i]->status_requests - before[i];
+    total += polls;
+    result.min_per_device = std::min(result.min_per_device, static_cast<double>(polls) / minutes);
+    result.max_per_device = std::max(result.max_per_device, static_cast<double>(polls) / minutes);
+  }
+  result.polls_per_minute = static_cast<double>(total) / minutes;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint8_t slots = argc > 1 ? static_cast<uint8_t>(strtoul(argv[1], nullptr, 10)) : 2;
+  uint32_t minutes = argc > 2 ? strtoul(argv[2], nullptr, 10) : 30;
+  if (slots == 0 || minutes == 0) {
+    fprintf(stderr, "usage: %s [slots >= 1] [minutes >= 1]\n", argv[0]);
+    return 2;
+  }
+
+  printf("%u slots, 60 s poll interval, %u simulated minutes\n", slots, minutes);
+  printf("softeners  polls/min  per softener (min-max)  peak links\n");
+  int failures = 0;
+  for (size_t softeners : SOFTENER_COUNTS) {
+    Result result = simulate(softeners, slots, minutes);
+    printf("%9zu  %9.1f  %10.2f - %-10.2f  %10u\n", softeners, result.polls_per_minute, result.min_per_device,
+           result.max_per_device, result.peak_connections);
+    if (result.peak_connections > slots) {
+      fprintf(stderr, "%zu softeners: %u links open at once, %u slots\n", softeners, result.peak_connections, slots);
+      failures++;
+    }
+    // Round-robin: nobody gets less than half the best-served softener's share
+    if (result.min_per_device < result.max_per_device / 2) {
+      fprintf(stderr, "%zu softeners: unfair share, %.2f to %.2f polls/min\n", softeners, result.min_per_device,
+              result.max_per_device);
+      failures++;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
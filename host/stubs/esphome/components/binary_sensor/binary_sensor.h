@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace binary_sensor {
+
+// Sink: keeps the last state, counts publishes and runs state callbacks
+class BinarySensor : public EntityBase {
+ public:
+  void publish_state(bool state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publish_count++;
+    for (auto &callback : this->callbacks_) {
+      callback(state);
+    }
+  }
+  void add_on_state_callback(std::function<void(bool)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  bool has_state() const { return has_state_; }
+
+  bool state{false};
+  uint32_t publish_count{0};
+
+ protected:
+  std::vector<std::function<void(bool)>> callbacks_;
+  bool has_state_{false};
+};
+
+}  // namespace binary_sensor
+}  // namespace esphome
@@ -0,0 +1,84 @@
+#pragma once
+
+// Host stand-in for ESPHome's ble_client: holds the address, the enabled flag
+// and the discovered characteristics. Connecting is left to the host program,
+// which watches enabled and delivers GATT events to the node.
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/esp32_ble_tracker/esp32_ble_tracker.h"
+
+namespace esphome {
+namespace ble_client {
+
+class BLEDescriptor {
+ public:
+  esp32_ble_tracker::ESPBTUUID uuid;
+  uint16_t handle{0};
+};
+
+class BLECharacteristic {
+ public:
+  BLEDescriptor *get_descriptor(esp32_ble_tracker::ESPBTUUID uuid) {
+    for (auto &descriptor : descriptors) {
+      if (descriptor.uuid == uuid) {
+        return &descriptor;
+      }
+    }
+    return nullptr;
+  }
+
+  esp32_ble_tracker::ESPBTUUID service;
+  esp32_ble_tracker::ESPBTUUID uuid;
+  uint16_t handle{0};
+  std::vector<BLEDescriptor> descriptors;
+};
+
+class BLEClient {
+ public:
+  void set_address(uint64_t address) {
+    address_ = address;
+    for (int i = 0; i < 6; i++) {
+      remote_bda_[i] = static_cast<uint8_t>(address >> (40 - 8 * i));
+    }
+  }
+  uint64_t get_address() const { return address_; }
+  void set_enabled(bool enabled) { this->enabled = enabled; }
+  uint8_t *get_remote_bda() { return remote_bda_; }
+  esp_gatt_if_t get_gattc_if() const { return gattc_if_; }
+  void set_gattc_if(esp_gatt_if_t gattc_if) { gattc_if_ = gattc_if; }
+  uint16_t get_conn_id() const { return 0; }
+
+  BLECharacteristic *get_characteristic(esp32_ble_tracker::ESPBTUUID service, esp32_ble_tracker::ESPBTUUID uuid) {
+    for (auto &characteristic : characteristics) {
+      if (characteristic.service == service && characteristic.uuid == uuid) {
+        return &characteristic;
+      }
+    }
+    return nullptr;
+  }
+
+  bool enabled{true};
+  std::vector<BLECharacteristic> characteristics;
+
+ protected:
+  uint64_t address_{0};
+  uint8_t remote_bda_[6]{};
+  esp_gatt_if_t gattc_if_{0};
+};
+
+class BLEClientNode {
+ public:
+  virtual ~BLEClientNode() = default;
+  virtual void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if,
+                                   esp_ble_gattc_cb_param_t *param) = 0;
+  void set_ble_client_parent(BLEClient *parent) { parent_ = parent; }
+  BLEClient *parent() { return parent_; }
+
+ protected:
+  BLEClient *parent_{nullptr};
+};
+
+}  // namespace ble_client
+}  // namespace esphome
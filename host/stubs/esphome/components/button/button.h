@@ -0,0 +1,17 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace button {
+
+class Button : public EntityBase {
+ public:
+  void press() { this->press_action(); }
+
+ protected:
+  virtual void press_action() = 0;
+};
+
+}  // namespace button
+}  // namespace esphome
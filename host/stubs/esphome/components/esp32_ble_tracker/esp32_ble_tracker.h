@@ -0,0 +1,152 @@
+#pragma once
+
+// Host stand-ins for ESPHome's esp32_ble_tracker and the parts of the ESP-IDF
+// GATT client API the transport uses. The API calls are forwarded to the
+// hooks in host_runtime.h, where a simulated radio can answer them.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+using esp_err_t = int;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+using esp_gatt_if_t = uint8_t;
+typedef uint8_t esp_bd_addr_t[6];
+
+enum esp_gattc_cb_event_t {
+  ESP_GATTC_OPEN_EVT,
+  ESP_GATTC_CLOSE_EVT,
+  ESP_GATTC_DISCONNECT_EVT,
+  ESP_GATTC_SEARCH_CMPL_EVT,
+  ESP_GATTC_REG_FOR_NOTIFY_EVT,
+  ESP_GATTC_WRITE_DESCR_EVT,
+  ESP_GATTC_WRITE_CHAR_EVT,
+  ESP_GATTC_NOTIFY_EVT,
+};
+
+enum esp_ble_addr_type_t {
+  BLE_ADDR_TYPE_PUBLIC = 0x00,
+  BLE_ADDR_TYPE_RANDOM = 0x01,
+  BLE_ADDR_TYPE_RPA_PUBLIC = 0x02,
+  BLE_ADDR_TYPE_RPA_RANDOM = 0x03,
+};
+
+enum esp_gatt_status_t { ESP_GATT_OK = 0x00, ESP_GATT_ERROR = 0x85 };
+enum esp_gatt_write_type_t { ESP_GATT_WRITE_TYPE_NO_RSP = 1, ESP_GATT_WRITE_TYPE_RSP = 2 };
+enum esp_gatt_auth_req_t { ESP_GATT_AUTH_REQ_NONE = 0 };
+
+union esp_ble_gattc_cb_param_t {
+  struct {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+  } open;
+  struct {
+    int reason;
+    uint16_t conn_id;
+  } disconnect;
+  struct {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+  } search_cmpl;
+  struct {
+    esp_gatt_status_t status;
+    uint16_t handle;
+  } reg_for_notify;
+  struct {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+    uint16_t handle;
+    uint16_t offset;
+  } write;
+  struct {
+    uint16_t conn_id;
+    uint16_t handle;
+    uint16_t value_len;
+    uint8_t *value;
+    bool is_notify;
+  } notify;
+};
+
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t server_bda, uint16_t handle);
+esp_err_t esp_ble_gattc_write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len,
+                                   uint8_t *value, esp_gatt_write_type_t write_type, esp_gatt_auth_req_t auth_req);
+esp_err_t esp_ble_gattc_write_char_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle,
+                                         uint16_t value_len, uint8_t *value, esp_gatt_write_type_t write_type,
+                                         esp_gatt_auth_req_t auth_req);
+
+namespace esphome {
+namespace esp32_ble_tracker {
+
+class ESPBTUUID {
+ public:
+  static ESPBTUUID from_raw(const std::string &data) {
+    ESPBTUUID uuid;
+    uuid.value_ = data;
+    return uuid;
+  }
+  static ESPBTUUID from_uint16(uint16_t value) { return from_raw(std::to_string(value)); }
+  bool operator==(const ESPBTUUID &other) const { return value_ == other.value_; }
+
+ protected:
+  std::string value_;
+};
+
+// One advertisement as the tracker hands it to its listeners
+class ESPBTDevice {
+ public:
+  ESPBTDevice() = default;
+  ESPBTDevice(uint64_t address, std::string name, int rssi = -60,
+              esp_ble_addr_type_t address_type = BLE_ADDR_TYPE_PUBLIC)
+      : name_(std::move(name)), rssi_(rssi), address_type_(address_type) {
+    for (int i = 0; i < 6; i++) {
+      address_[i] = static_cast<uint8_t>(address >> (40 - 8 * i));
+    }
+  }
+
+  const std::string &get_name() const { return name_; }
+  int get_rssi() const { return rssi_; }
+  esp_ble_addr_type_t get_address_type() const { return address_type_; }
+  const uint8_t *address() const { return address_; }
+  uint64_t address_uint64() const {
+    uint64_t address = 0;
+    for (uint8_t byte : address_) {
+      address = (address << 8) | byte;
+    }
+    return address;
+  }
+
+ protected:
+  std::string name_;
+  int rssi_{0};
+  esp_ble_addr_type_t address_type_{BLE_ADDR_TYPE_PUBLIC};
+  uint8_t address_[6]{};
+};
+
+class ESP32BLETracker;
+
+class ESPBTDeviceListener {
+ public:
+  virtual ~ESPBTDeviceListener() = default;
+  virtual bool parse_device(const ESPBTDevice &device) = 0;
+  void set_parent(ESP32BLETracker *parent) { parent_ = parent; }
+
+ protected:
+  ESP32BLETracker *parent_{nullptr};
+};
+
+enum class ClientState : uint8_t {
+  INIT,
+  DISCONNECTING,
+  IDLE,
+  DISCOVERED,
+  CONNECTING,
+  CONNECTED,
+  ESTABLISHED,
+};
+
+}  // namespace esp32_ble_tracker
+}  // namespace esphome
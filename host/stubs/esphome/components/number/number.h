@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace number {
+
+// Sink: keeps the last state, counts publishes and runs state callbacks;
+// make_call() is not modelled
+class Number : public EntityBase {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publish_count++;
+    for (auto &callback : this->callbacks_) {
+      callback(state);
+    }
+  }
+  void add_on_state_callback(std::function<void(float)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  bool has_state() const { return has_state_; }
+
+  float state{0.0f};
+  uint32_t publish_count{0};
+
+ protected:
+  virtual void control(float value) = 0;
+  std::vector<std::function<void(float)>> callbacks_;
+  bool has_state_{false};
+};
+
+}  // namespace number
+}  // namespace esphome
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace switch_ {
+
+// Sink: keeps the last state and counts publishes
+class Switch : public EntityBase {
+ public:
+  void publish_state(bool state) {
+    this->state = state;
+    this->publish_count++;
+  }
+
+  bool state{false};
+  uint32_t publish_count{0};
+
+ protected:
+  virtual void write_state(bool state) = 0;
+};
+
+}  // namespace switch_
+}  // namespace esphome
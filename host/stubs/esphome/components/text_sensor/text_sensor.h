@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace text_sensor {
+
+// Sink: keeps the last state, counts publishes and runs state callbacks
+class TextSensor : public EntityBase {
+ public:
+  void publish_state(const std::string &state) {
+    this->raw_state = state;
+    this->state = state;
+    this->has_state_ = true;
+    this->publish_count++;
+    for (auto &callback : this->callbacks_) {
+      callback(state);
+    }
+  }
+  void add_on_state_callback(std::function<void(std::string)> &&callback) {
+    this->callbacks_.push_back(std::move(callback));
+  }
+  bool has_state() const { return has_state_; }
+  const std::string &get_state() const { return state; }
+  const std::string &get_raw_state() const { return raw_state; }
+
+  std::string state;
+  std::string raw_state;
+  uint32_t publish_count{0};
+
+ protected:
+  std::vector<std::function<void(std::string)>> callbacks_;
+  bool has_state_{false};
+};
+
+}  // namespace text_sensor
+}  // namespace esphome
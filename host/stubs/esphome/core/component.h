@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float DATA;
+extern const float AFTER_BLUETOOTH;
+}  // namespace setup_priority
+
+// Host programs call setup()/loop() themselves; there is no scheduler
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+
+  void status_set_warning(const char * = nullptr) { warning_ = true; }
+  void status_clear_warning() { warning_ = false; }
+  bool status_has_warning() const { return warning_; }
+
+ protected:
+  bool warning_{false};
+};
+
+class EntityBase {
+ public:
+  const char *get_name() const { return ""; }
+};
+
+}  // namespace esphome
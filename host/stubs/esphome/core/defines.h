@@ -0,0 +1,3 @@
+#pragma once
+// Host build: no generated defines. CMake passes USE_ESP32 so the BLE
+// transport compiles against the stand-ins in esp32_ble_tracker.h.
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+// Simulated clock, advanced by the host programs (host_runtime.h)
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+}  // namespace esphome
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+uint32_t random_uint32();
+uint32_t fnv1_hash(const std::string &str);
+std::string format_hex(const uint8_t *data, size_t length);
+std::string format_hex_pretty(const uint8_t *data, size_t length);
+
+template<typename T> class Parented {
+ public:
+  Parented() {}
+  void set_parent(T *parent) { parent_ = parent; }
+  T *get_parent() const { return parent_; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+}  // namespace esphome
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+#define ESPHOME_LOG_LEVEL_VERY_VERBOSE 7
+
+// ESPHome's default: DEBUG and above are compiled in, VERBOSE is not
+#ifndef ESPHOME_LOG_LEVEL
+#define ESPHOME_LOG_LEVEL ESPHOME_LOG_LEVEL_DEBUG
+#endif
+
+namespace esphome {
+namespace host {
+// Counts every line and echoes it when enabled (host_runtime.cpp)
+void log_line(int level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+}  // namespace host
+}  // namespace esphome
+
+#define ESPHOME_HOST_LOG(level, tag, ...) ::esphome::host::log_line(level, tag, __VA_ARGS__)
+
+#define ESP_LOGE(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERBOSE
+#define ESP_LOGV(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+#else
+#define ESP_LOGV(tag, ...) do {} while (0)
+#endif
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERY_VERBOSE
+#define ESP_LOGVV(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_VERY_VERBOSE, tag, __VA_ARGS__)
+#else
+#define ESP_LOGVV(tag, ...) do {} while (0)
+#endif
+
+#define LOG_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_TEXT_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_BINARY_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_NUMBER(prefix, type, obj) (void) (obj)
+#define LOG_SWITCH(prefix, type, obj) (void) (obj)
+#define LOG_BUTTON(prefix, type, obj) (void) (obj)
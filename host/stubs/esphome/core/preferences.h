@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+// In-memory flash: survives objects, not the process
+inline std::map<uint32_t, std::vector<uint8_t>> &host_preference_store() {
+  static std::map<uint32_t, std::vector<uint8_t>> store;
+  return store;
+}
+
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t key) : key_(key) {}
+
+  template<typename T> bool save(const T *src) {
+    auto &stored = host_preference_store()[key_];
+    stored.assign(reinterpret_cast<const uint8_t *>(src), reinterpret_cast<const uint8_t *>(src) + sizeof(T));
+    return true;
+  }
+  template<typename T> bool load(T *dest) {
+    auto it = host_preference_store().find(key_);
+    if (it == host_preference_store().end() || it->second.size() != sizeof(T)) {
+      return false;
+    }
+    memcpy(dest, it->second.data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  uint32_t key_{0};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool = false) {
+    return ESPPreferenceObject(type);
+  }
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
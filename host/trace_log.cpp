@@ -0,0 +1,72 @@
+#include "trace_log.h"
+
+#include <cctype>
+#include <cstdlib>
+
+namespace esphome {
+namespace host {
+
+namespace {
+
+int hex_digit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+  return (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+// Finds "Trace <hex offset>: " and returns the position after it, or npos.
+// The "Trace: N bytes" header and "Trace end" lines do not match.
+size_t find_trace_data(const std::string &line, unsigned long &offset) {
+  static const char MARKER[] = "Trace ";
+  for (size_t pos = line.find(MARKER); pos != std::string::npos; pos = line.find(MARKER, pos + 1)) {
+    size_t digits = pos + sizeof(MARKER) - 1;
+    size_t end = digits;
+    while (end < line.size() && hex_digit(line[end]) >= 0) {
+      end++;
+    }
+    if (end == digits || line.compare(end, 2, ": ") != 0) {
+      continue;
+    }
+    offset = strtoul(line.substr(digits, end - digits).c_str(), nullptr, 16);
+    return end + 2;
+  }
+  return std::string::npos;
+}
+
+}  // namespace
+
+bool parse_trace_log(std::istream &in, std::vector<uint8_t> &trace, std::string &error) {
+  size_t start = trace.size();
+  std::string line;
+  for (size_t number = 1; std::getline(in, line); number++) {
+    unsigned long offset;
+    size_t pos = find_trace_data(line, offset);
+    if (pos == std::string::npos) {
+      continue;
+    }
+    if (offset != trace.size() - start) {
+      error = "line " + std::to_string(number) + ": offset " + std::to_string(offset) + ", expected " +
+              std::to_string(trace.size() - start) + " (lines missing from the log?)";
+      return false;
+    }
+    size_t end = pos;
+    while (end + 1 < line.size() && hex_digit(line[end]) >= 0 && hex_digit(line[end + 1]) >= 0) {
+      trace.push_back(static_cast<uint8_t>(hex_digit(line[end]) << 4 | hex_digit(line[end + 1])));
+      end += 2;
+    }
+    if (end == pos || (end < line.size() && hex_digit(line[end]) >= 0)) {
+      error = "line " + std::to_string(number) + ": malformed hex data";
+      return false;
+    }
+  }
+  if (trace.size() == start) {
+    error = "no \"Trace NNNN:\" lines found";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace host
+}  // namespace esphome
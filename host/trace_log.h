@@ -0,0 +1,25 @@
+/**
+ * dump_trace log parser
+ *
+ * Turns the "Trace NNNN: <hex>" lines that dump_trace() logs back into the
+ * binary trace replay_trace() takes. Lines can come straight from the ESPHome
+ * log, with or without the "[I][culligan_water_softener]:" prefix and colour
+ * codes; everything else in the log is ignored.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace host {
+
+// Appends the trace bytes to trace. Fails, with a reason in error, on a
+// malformed line or a missing one (offsets must run on without gaps).
+bool parse_trace_log(std::istream &in, std::vector<uint8_t> &trace, std::string &error);
+
+}  // namespace host
+}  // namespace esphome
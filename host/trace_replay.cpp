@@ -0,0 +1,62 @@
+/**
+ * Replays a dump_trace log through the protocol core
+ *
+ * Reads a log containing the output of the dump_trace button (a saved
+ * ESPHome log is fine as is), rebuilds the binary trace and feeds its
+ * notifications through CulliganProtocol with every entity attached, on a
+ * clock stepped by the recorded delays. Prints each publish as it happens:
+ *
+ *   <seconds into the trace>  <platform> <entity id>: <state>
+ *
+ * Entity ids are the SensorId/TextSensorId/BinarySensorId/NumberId values.
+ *
+ *   trace_replay [log file]   (stdin when omitted)
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "esphome/core/hal.h"
+#include "host_protocol.h"
+#include "host_runtime.h"
+#include "trace_log.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+int main(int argc, char **argv) {
+  std::vector<uint8_t> trace;
+  std::string error;
+  bool parsed;
+  if (argc > 1) {
+    std::ifstream file(argv[1]);
+    if (!file) {
+      fprintf(stderr, "cannot open %s\n", argv[1]);
+      return 2;
+    }
+    parsed = parse_trace_log(file, trace, error);
+  } else {
+    parsed = parse_trace_log(std::cin, trace, error);
+  }
+  if (!parsed) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  set_millis(0);
+  HostProtocol protocol;
+  protocol.attach_all_entities();
+  protocol.record_publishes([](const std::string &publish) {
+    printf("%10.3f  %s\n", millis() / 1000.0, publish.c_str());
+  });
+  protocol.setup();
+  size_t notifications = protocol.replay_trace(trace.data(), trace.size(), [](uint16_t delay_ms) {
+    advance_millis(delay_ms);
+  });
+  fprintf(stderr, "%zu notifications replayed from %zu trace bytes, %u publishes\n", notifications, trace.size(),
+          protocol.publish_count());
+  return 0;
+}
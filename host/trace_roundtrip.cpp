@@ -0,0 +1,125 @@
+/**
+ * dump_trace -> trace_replay round trip
+ *
+ * Runs a session against the simulated softener with the trace enabled and
+ * notes every publish a notification causes. It then dumps the trace to a
+ * captured log, parses the log back (trace_log.h) and replays it into a
+ * fresh CulliganProtocol, which must publish the same sequence. The log
+ * can be saved for trace_replay.
+ *
+ *   trace_roundtrip [polls] [log file]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "esphome/core/preferences.h"
+#include "fake_softener.h"
+#include "host_protocol.h"
+#include "host_runtime.h"
+#include "trace_log.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+const uint32_t POLL_INTERVAL_MS = 60000;
+const uint32_t NOTIFICATION_GAP_MS = 30;
+
+// Delivers the device's answer to every write the protocol made, one
+// notification at a time, noting the publishes each causes
+void answer_writes(HostProtocol &protocol, const FakeSoftener &device, bool &recording) {
+  while (!protocol.writes.empty()) {
+    std::vector<uint8_t> write = protocol.writes.front();
+    protocol.writes.erase(protocol.writes.begin());
+    for (auto &notification : device.respond(write.data(), write.size())) {
+      advance_millis(NOTIFICATION_GAP_MS);
+      recording = true;
+      protocol.handle_notification(notification.data(), notification.size());
+      recording = false;
+      protocol.complete_writes();
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t polls = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20;
+
+  // Live session, the trace sized to hold all of it
+  set_millis(1000);
+  host_preference_store().clear();
+  std::vector<std::string> live;
+  bool recording = false;
+  HostProtocol session;
+  session.set_trace_buffer_size(65536);
+  session.attach_all_entities();
+  session.record_publishes([&](const std::string &publish) {
+    if (recording) {
+      live.push_back(publish);
+    }
+  });
+  session.setup();
+  session.set_link_connected(true);
+  session.send_handshake_request();
+  session.complete_writes();
+  FakeSoftener device;
+  answer_writes(session, device, recording);
+  for (uint32_t i = 0; i < polls; i++) {
+    advance_millis(POLL_INTERVAL_MS);
+    device.tick();
+    session.loop();  // Schedules this poll's requests
+    session.complete_writes();
+    answer_writes(session, device, recording);
+  }
+
+  std::string log;
+  set_log_capture(&log);
+  session.dump_trace();
+  set_log_capture(nullptr);
+  if (argc > 2) {
+    std::ofstream(argv[2]) << log;
+  }
+
+  std::istringstream in(log);
+  std::vector<uint8_t> trace;
+  std::string error;
+  if (!parse_trace_log(in, trace, error)) {
+    fprintf(stderr, "parse failed: %s\n", error.c_str());
+    return 1;
+  }
+
+  // Replay into a fresh instance with nothing cached
+  set_millis(0);
+  host_preference_store().clear();
+  std::vector<std::string> replayed;
+  HostProtocol replay;
+  replay.attach_all_entities();
+  replay.record_publishes([&](const std::string &publish) { replayed.push_back(publish); });
+  replay.setup();
+  size_t notifications = replay.replay_trace(trace.data(), trace.size(), [](uint16_t delay_ms) {
+    advance_millis(delay_ms);
+  });
+
+  printf("%zu trace bytes, %zu notifications, %zu publishes live, %zu replayed\n", trace.size(), notifications,
+         live.size(), replayed.size());
+  for (size_t i = 0; i < std::max(live.size(), replayed.size()); i++) {
+    const char *expected = i < live.size() ? live[i].c_str() : "(none)";
+    const char *actual = i < replayed.size() ? replayed[i].c_str() : "(none)";
+    if (live.size() <= i || replayed.size() <= i || live[i] != replayed[i]) {
+      fprintf(stderr, "publish %zu differs: live %s, replayed %s\n", i, expected, actual);
+      return 1;
+    }
+  }
+  if (live.empty()) {
+    fprintf(stderr, "session published nothing\n");
+    return 1;
+  }
+  return 0;
+}
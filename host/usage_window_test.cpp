@@ -0,0 +1,121 @@
+/**
+ * Incremental usage window statistics against a sorted reference
+ *
+ * Feeds the daily usage history through a random mix of today's entry
+ * growing, midnight shifts and unrelated histories (a rescan), and checks
+ * every window's minimum, maximum and median against the values sorted
+ * from scratch.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "esphome/core/helpers.h"
+#include "host_protocol.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+const uint8_t WINDOW_DAYS[USAGE_WINDOW_COUNT] = {7, 14, 31, 62};
+
+class UsageProtocol : public HostProtocol {
+ public:
+  void feed(const uint8_t *history) { this->parse_statistics_daily_usage(history); }
+};
+
+// Mostly small days with the odd zero and spike, so values repeat and the
+// minimum and maximum often leave the window
+uint8_t random_day() {
+  uint32_t r = random_uint32() % 20;
+  if (r == 0) {
+    return 0;
+  }
+  if (r == 1) {
+    return 200 + random_uint32() % 56;
+  }
+  return 1 + random_uint32() % 12;
+}
+
+void check_windows(const UsageProtocol &protocol, const uint8_t *history, int step) {
+  for (uint8_t w = 0; w < USAGE_WINDOW_COUNT; w++) {
+    std::vector<uint8_t> values;
+    for (uint8_t i = frames::DAILY_USAGE_DAYS - WINDOW_DAYS[w]; i < frames::DAILY_USAGE_DAYS; i++) {
+      if (history[i] != 0) {
+        values.push_back(history[i]);
+      }
+    }
+    if (values.empty()) {
+      continue;  // Nothing published for an empty window
+    }
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    float median = (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0f;
+
+    const size_t first = SENSOR_USAGE_STAT + w * USAGE_STAT_COUNT;
+    float min = protocol.sensor_sinks[first + USAGE_STAT_MINIMUM].state;
+    float max = protocol.sensor_sinks[first + USAGE_STAT_MAXIMUM].state;
+    float med = protocol.sensor_sinks[first + USAGE_STAT_MEDIAN].state;
+    CHECK(min == values.front() * frames::DAILY_USAGE_SCALE);
+    CHECK(max == values.back() * frames::DAILY_USAGE_SCALE);
+    CHECK(med == median * frames::DAILY_USAGE_SCALE);
+    if (min != values.front() * frames::DAILY_USAGE_SCALE || max != values.back() * frames::DAILY_USAGE_SCALE ||
+        med != median * frames::DAILY_USAGE_SCALE) {
+      fprintf(stderr, "  step %d, %u-day window: got %g/%g/%g\n", step, WINDOW_DAYS[w], min, max, med);
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  UsageProtocol protocol;
+  protocol.attach_all_entities();
+
+  uint8_t history[frames::DAILY_USAGE_DAYS];
+  for (auto &day : history) {
+    day = random_day();
+  }
+  protocol.feed(history);
+  check_windows(protocol, history, 0);
+
+  for (int step = 1; step <= 5000 && failures == 0; step++) {
+    uint32_t r = random_uint32() % 100;
+    if (r < 60) {
+      // Today's usage grows
+      history[frames::DAILY_USAGE_DAYS - 1] += random_uint32() % 3;
+    } else if (r < 98) {
+      // Midnight: the history shifts by a day
+      memmove(history, history + 1, frames::DAILY_USAGE_DAYS - 1);
+      history[frames::DAILY_USAGE_DAYS - 1] = random_day();
+    } else {
+      // Unrelated history: rescanned from scratch
+      for (auto &day : history) {
+        day = random_day();
+      }
+    }
+    protocol.feed(history);
+    check_windows(protocol, history, step);
+  }
+
+  if (failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("usage windows match the sorted reference\n");
+  return 0;
+}